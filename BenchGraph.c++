@@ -0,0 +1,315 @@
+// -----------------------------
+// projects/graph/BenchGraph.c++
+// Copyright (C) 2014
+// Glenn P. Downing
+// -----------------------------
+
+/*
+To compile the benchmark:
+    % g++-4.7 -O3 -pedantic -std=c++11 -Wall BenchGraph.c++ -o BenchGraph -lpthread
+
+To run the benchmark:
+    % BenchGraph
+ */
+
+// --------
+// includes
+// --------
+
+#include <chrono>   // steady_clock, duration
+#include <cstdio>   // printf
+#include <thread>   // hardware_concurrency
+#include <utility>  // swap
+#include <vector>   // vector
+
+#include "Graph.h"
+
+// -----------
+// next_random
+// -----------
+
+/**
+ * @param state - generator state, advanced on every call
+ * @return unsigned
+ * returns the next value of a 64-bit linear congruential generator
+ */
+unsigned next_random (unsigned long long& state) {
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (unsigned)(state >> 33);}
+
+// ----------
+// make_graph
+// ----------
+
+/**
+ * @param n - number of vertices
+ * @param m - number of edges to try to add
+ * @param g - empty graph to fill
+ * fills g with n vertices and up to m random edges; half of the edges point
+ * at the first n / 100 vertices so the in-degrees are skewed
+ */
+void make_graph (int n, int m, Graph& g) {
+	unsigned long long state = 378;
+	for (int i = 0; i < n; ++i)
+		add_vertex(g);
+	for (int i = 0; i < m; ++i) {
+		const int a = next_random(state) % n;
+		const int b = (i % 2) ? next_random(state) % (n / 100 + 1) : next_random(state) % n;
+		add_edge(a, b, g);}}
+
+// -------
+// seconds
+// -------
+
+/**
+ * @param b - start time
+ * @return double
+ * returns the seconds elapsed since b
+ */
+double seconds (std::chrono::steady_clock::time_point b) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - b).count();}
+
+// --------------
+// bench_pagerank
+// --------------
+
+/**
+ * @param g - graph to rank
+ * prints PageRank iterations per second for 1, 2, 4, ... threads
+ */
+void bench_pagerank (const Graph& g) {
+	std::printf("pagerank: %lu vertices, %lu edges\n", (unsigned long)num_vertices(g), (unsigned long)num_edges(g));
+	const std::size_t most = std::max(1u, std::thread::hardware_concurrency());
+	for (std::size_t t = 1; t <= most; t *= 2) {
+		std::vector<double> ranks;
+		const int           reps = 20;
+		std::size_t         iter = 0;
+		const auto          b    = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; ++r)
+			iter += pagerank(g, ranks, 0.85, 0, 50, t);
+		const double s = seconds(b);
+		std::printf("  threads %2lu: %10.1f iterations/s\n", (unsigned long)t, iter / s);}}
+
+// ---------
+// make_grid
+// ---------
+
+/**
+ * @param side - number of rows and of columns
+ * @param g - empty graph to fill
+ * fills g with a side x side grid, each cell linked both ways to its right and
+ * lower neighbors, under shuffled labels so that neighbors are far apart in memory
+ */
+void make_grid (int side, Graph& g) {
+	const int          n     = side * side;
+	unsigned long long state = 62;
+	std::vector<int>   label(n);
+	for (int i = 0; i < n; ++i)
+		label[i] = i;
+	for (int i = n - 1; i > 0; --i)
+		std::swap(label[i], label[next_random(state) % (i + 1)]);
+	for (int i = 0; i < n; ++i)
+		add_vertex(g);
+	for (int r = 0; r < side; ++r)
+		for (int c = 0; c < side; ++c) {
+			const int v = label[r * side + c];
+			if (c + 1 < side) {
+				add_edge(v, label[r * side + c + 1], g);
+				add_edge(label[r * side + c + 1], v, g);}
+			if (r + 1 < side) {
+				add_edge(v, label[(r + 1) * side + c], g);
+				add_edge(label[(r + 1) * side + c], v, g);}}}
+
+// ---
+// bfs
+// ---
+
+/**
+ * @param offsets - CSR row offsets, indexed by vertex descriptor
+ * @param targets - CSR targets, vertex descriptors
+ * @return std::size_t
+ * visits every vertex breadth first and returns the number of vertices reached;
+ * only the memory layout given by the labels differs between orderings
+ */
+std::size_t bfs (const std::vector<std::size_t>& offsets, const std::vector<int>& targets) {
+	const int         n = (int)offsets.size() - 1;
+	std::vector<char> seen(n, 0);
+	std::vector<int>  queue;
+	queue.reserve(n);
+	for (int s = 0; s < n; ++s) {
+		if (seen[s])
+			continue;
+		seen[s] = 1;
+		queue.push_back(s);
+		for (std::size_t head = queue.size() - 1; head < queue.size(); ++head) {
+			const int v = queue[head];
+			for (std::size_t e = offsets[v]; e < offsets[v + 1]; ++e)
+				if (!seen[targets[e]]) {
+					seen[targets[e]] = 1;
+					queue.push_back(targets[e]);}}}
+	return queue.size();}
+
+// -------------
+// bench_reorder
+// -------------
+
+/**
+ * @param g - graph to reorder, with dense descriptors
+ * prints BFS time over a CSR copy of g and PageRank time, which includes building
+ * its own CSR from the adjacency lists, for g as given and after each strategy
+ */
+void bench_reorder (const Graph& g) {
+	const char*           names[]      = {"original", "degree_sort", "reverse_cuthill_mckee", "breadth_first"};
+	const Graph::ordering strategies[] = {Graph::degree_sort, Graph::reverse_cuthill_mckee, Graph::breadth_first};
+	std::printf("reorder: %lu vertices, %lu edges\n", (unsigned long)num_vertices(g), (unsigned long)num_edges(g));
+	for (int k = 0; k < 4; ++k) {
+		Graph h = g;
+		if (k > 0)
+			reorder(h, strategies[k - 1]);
+		std::vector<std::size_t> offsets(1, 0);
+		std::vector<int>         targets;
+		for (std::size_t v = 0; v < num_vertices(h); ++v) {
+			std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> q = adjacent_vertices((Graph::vertex_descriptor)v, h);
+			targets.insert(targets.end(), q.first, q.second);
+			offsets.push_back(targets.size());}
+
+		const int   reps    = 10;
+		std::size_t reached = 0;
+		auto        b       = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; ++r)
+			reached += bfs(offsets, targets);
+		const double bfs_ms = seconds(b) * 1000 / reps;
+		std::vector<double> ranks;
+		b = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; ++r)
+			pagerank(h, ranks, 0.85, 0, 20, 1);
+		const double pr_ms = seconds(b) * 1000 / reps;
+		std::printf("  %-22s bfs %8.3f ms   pagerank %8.3f ms   (%lu reached)\n", names[k], bfs_ms, pr_ms, (unsigned long)(reached / reps));}}
+
+// ----------
+// bench_edge
+// ----------
+
+/**
+ * prints the cost of edge() on a hub with and without its bitmap
+ */
+void bench_edge () {
+	const int          n     = 1 << 20;
+	const int          m     = 1 << 18;
+	unsigned long long state = 29;
+	Graph              g;
+	for (int i = 0; i < m; ++i)
+		add_edge(0, next_random(state) % n, g);
+	std::printf("edge: hub with %lu out-edges\n", (unsigned long)num_edges(g));
+	const Graph::vertices_size_type thresholds[] = {Graph::vertices_size_type(-1), 4096};
+	const char*                     names[]      = {"sorted vector", "bitmap"};
+	for (int k = 0; k < 2; ++k) {
+		set_hub_degree(thresholds[k], g);
+		const int   queries = 1 << 22;
+		std::size_t found   = 0;
+		const auto  b       = std::chrono::steady_clock::now();
+		for (int q = 0; q < queries; ++q)
+			found += edge(0, next_random(state) % n, g).second;
+		const double s = seconds(b);
+		std::printf("  %-14s %8.1f ns/query   (%lu found)\n", names[k], s * 1e9 / queries, (unsigned long)found);}}
+
+// ---------
+// bench_log
+// ---------
+
+/**
+ * prints the cost of add_edge without a log and with logs of several batch sizes
+ */
+void bench_log () {
+	const std::size_t batches[] = {0, 1, 64, 4096};
+	std::printf("log: add_edge\n");
+	for (int k = 0; k < 4; ++k) {
+		const int          m     = batches[k] == 1 ? 2000 : 200000;
+		unsigned long long state = 11;
+		Graph              g;
+		for (int i = 0; i < 10000; ++i)
+			add_vertex(g);
+		if (batches[k] > 0)
+			open_log("BenchGraph.wal", batches[k], g);
+		const auto b = std::chrono::steady_clock::now();
+		for (int i = 0; i < m; ++i)
+			add_edge(next_random(state) % 10000, next_random(state) % 10000, g);
+		close_log(g);
+		const double s = seconds(b);
+		std::remove("BenchGraph.wal");
+		if (batches[k] == 0)
+			std::printf("  no log       %8.1f ns/edge\n", s * 1e9 / m);
+		else
+			std::printf("  batch %-6lu %8.1f ns/edge\n", (unsigned long)batches[k], s * 1e9 / m);}}
+
+// -----------
+// bench_batch
+// -----------
+
+/**
+ * @param g - graph to query
+ * prints the cost of a batch of 1-hop neighborhoods with a new and with a kept query_engine
+ */
+void bench_batch (const Graph& g) {
+	std::printf("neighborhoods: batches of 64 1-hop queries\n");
+	std::vector<Graph::vertex_descriptor> sources;
+	for (int i = 0; i < 64; ++i)
+		sources.push_back((Graph::vertex_descriptor)(i * 257 % num_vertices(g)));
+	const int           reps = 50;
+	std::size_t         seen = 0;
+	auto                b    = std::chrono::steady_clock::now();
+	for (int r = 0; r < reps; ++r)
+		seen += neighborhoods(g, sources, 1).size();
+	const double        once = seconds(b) * 1000 / reps;
+	Graph::query_engine engine(g);
+	b = std::chrono::steady_clock::now();
+	for (int r = 0; r < reps; ++r)
+		seen += engine.neighborhoods(sources, 1).size();
+	const double        kept = seconds(b) * 1000 / reps;
+	std::printf("  new engine  %8.3f ms/batch\n  kept engine %8.3f ms/batch   (%lu answers)\n", once, kept, (unsigned long)seen);}
+
+// -----------
+// bench_walks
+// -----------
+
+/**
+ * @param g - graph to walk
+ * prints random walk steps per second for 1, 2, 4, ... threads, uniform and node2vec
+ */
+void bench_walks (const Graph& g) {
+	std::printf("random_walks: %lu vertices, length 80\n", (unsigned long)num_vertices(g));
+	std::vector<Graph::vertex_descriptor> starts;
+	for (int r = 0; r < 5; ++r)
+		for (std::size_t v = 0; v < num_vertices(g); ++v)
+			starts.push_back((Graph::vertex_descriptor)v);
+	std::vector<Graph::vertex_descriptor> out(starts.size() * 80);
+	const std::size_t most = std::max(1u, std::thread::hardware_concurrency());
+	for (int k = 0; k < 2; ++k) {
+		Graph::walk_options o;
+		if (k == 1) {
+			o.p = 0.5;
+			o.q = 2;}
+		for (std::size_t t = 1; t <= most; t *= 2) {
+			o.threads = t;
+			const auto        b     = std::chrono::steady_clock::now();
+			const std::size_t steps = random_walks(g, starts, 80, out, o);
+			const double      s     = seconds(b);
+			std::printf("  %-8s threads %2lu: %12.0f steps/s\n", k ? "node2vec" : "uniform", (unsigned long)t, steps / s);}}}
+
+// ----
+// main
+// ----
+
+int main () {
+	Graph g;
+	make_graph(20000, 200000, g);
+	bench_pagerank(g);
+	{
+		Graph grid;
+		make_grid(700, grid);
+		bench_reorder(grid);}
+	bench_edge();
+	bench_log();
+	bench_batch(g);
+	bench_walks(g);
+	return 0;}
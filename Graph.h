@@ -19,10 +19,119 @@
 #include <iostream>
 #include <memory>    // allocator
 #include <algorithm>
+#include <atomic>             // atomic
+#include <bitset>             // bitset
+#include <cmath>              // fabs, isfinite
+#include <cstdint>            // uint64_t
+#include <cstdio>             // FILE, fopen, fread, fwrite, rename
+#include <cstring>            // memcpy, memcmp
+#include <iterator>           // random_access_iterator_tag
+#include <condition_variable> // condition_variable
+#include <functional>         // function
+#include <mutex>              // mutex, lock_guard, unique_lock
+#include <set>                // set
+#include <string>             // string
+#include <thread>             // thread
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>           // fsync
+#endif
 
 using namespace std;
 
 
+// -----------
+// thread_pool
+// -----------
+
+/**
+ * Fixed set of worker threads that run one task per worker and block the
+ * caller until every worker is done. The calling thread acts as worker 0.
+ */
+class thread_pool {
+private:
+	// ----
+	// data
+	// ----
+
+	vector<std::thread> workers;
+	std::mutex m;
+	std::condition_variable start;
+	std::condition_variable done;
+	const std::function<void (std::size_t)>* task;
+	std::size_t generation;
+	std::size_t pending;
+	bool stop;
+
+	/**
+	 * @param id - worker id
+	 * waits for each new generation of work and runs it as worker id
+	 */
+	void work (std::size_t id) {
+		std::size_t seen = 0;
+		while (true) {
+			const std::function<void (std::size_t)>* t;
+			{
+				std::unique_lock<std::mutex> lock(m);
+				start.wait(lock, [&] () {return stop || generation != seen;});
+				if (stop)
+					return;
+				seen = generation;
+				t    = task;}
+			(*t)(id);
+			std::lock_guard<std::mutex> lock(m);
+			if (--pending == 0)
+				done.notify_one();}}
+
+public:
+	// ------------
+	// constructors
+	// ------------
+
+	/**
+	 * @param n - number of workers, 0 for one per hardware thread
+	 * starts n - 1 background threads; the caller is the nth worker
+	 */
+	explicit thread_pool (std::size_t n = 0) : task(0), generation(0), pending(0), stop(false) {
+		if (n == 0)
+			n = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		for (std::size_t i = 1; i < n; ++i)
+			workers.push_back(std::thread(&thread_pool::work, this, i));}
+
+	thread_pool (const thread_pool&) = delete;
+	thread_pool& operator = (const thread_pool&) = delete;
+
+	~thread_pool () {
+		{
+			std::lock_guard<std::mutex> lock(m);
+			stop = true;}
+		start.notify_all();
+		for (std::size_t i = 0; i < workers.size(); ++i)
+			workers[i].join();}
+
+	/**
+	 * @return std::size_t
+	 * returns the number of workers, including the caller
+	 */
+	std::size_t size () const {
+		return workers.size() + 1;}
+
+	/**
+	 * @param f - task, called once with each worker id in [0, size())
+	 * runs f on every worker and returns when all of them have finished
+	 */
+	void run (const std::function<void (std::size_t)>& f) {
+		{
+			std::lock_guard<std::mutex> lock(m);
+			task    = &f;
+			pending = workers.size();
+			++generation;}
+		start.notify_all();
+		f(0);
+		std::unique_lock<std::mutex> lock(m);
+		done.wait(lock, [&] () {return pending == 0;});}
+};
+
 // -----
 // Graph
 // -----
@@ -41,6 +150,288 @@ public:
 	typedef std::size_t vertices_size_type;
 	typedef std::size_t edges_size_type;
 
+	// vertex orderings understood by reorder
+	enum ordering {degree_sort, reverse_cuthill_mckee, breadth_first};
+private:
+	// ------
+	// column
+	// ------
+
+	/**
+	 * One property column, indexed by dense vertex or edge index.
+	 */
+	struct column {
+		virtual ~column () {}
+		virtual column* clone () const = 0;
+		virtual void grow (std::size_t n) = 0;
+		virtual void permute (const vector<std::size_t>& from) = 0;};
+
+	template <typename T>
+	struct typed_column : column {
+		vector<T> data;
+		T         init; // value of every new slot
+
+		explicit typed_column (const T& v) : init(v) {}
+
+		column* clone () const {
+			return new typed_column(*this);}
+
+		void grow (std::size_t n) {
+			if (n > data.size())
+				data.resize(n, init);}
+
+		// slot i takes the value of old slot from[i]
+		void permute (const vector<std::size_t>& from) {
+			vector<T> moved(from.size(), init);
+			for (std::size_t i = 0; i < from.size(); ++i)
+				moved[i] = data[from[i]];
+			data.swap(moved);}};
+
+	// -------
+	// columns
+	// -------
+
+	/**
+	 * The property columns of one kind; copies of a graph get copies of its columns.
+	 */
+	class columns {
+	private:
+		vector<column*> list;
+		std::size_t     n; // slots in every column
+
+	public:
+		columns () : n(0) {}
+
+		columns (const columns& that) : n(that.n) {
+			for (std::size_t i = 0; i < that.list.size(); ++i)
+				list.push_back(that.list[i]->clone());}
+
+		columns& operator = (columns that) {
+			list.swap(that.list);
+			std::swap(n, that.n);
+			return *this;}
+
+		~columns () {
+			for (std::size_t i = 0; i < list.size(); ++i)
+				delete list[i];}
+
+		template <typename T>
+		typed_column<T>* add (const T& init) {
+			typed_column<T>* c = new typed_column<T>(init);
+			c->grow(n);
+			list.push_back(c);
+			return c;}
+
+		void grow (std::size_t m) {
+			if (m <= n)
+				return;
+			n = m;
+			for (std::size_t i = 0; i < list.size(); ++i)
+				list[i]->grow(m);}
+
+		void permute (const vector<std::size_t>& from) {
+			n = from.size();
+			for (std::size_t i = 0; i < list.size(); ++i)
+				list[i]->permute(from);}};
+
+	// -------
+	// journal
+	// -------
+
+	/**
+	 * Append-only binary log of the mutations of one graph. The file starts with
+	 * "GLOG" and the generation of the snapshot it continues; each record is an
+	 * op byte and two 32-bit arguments. Records are buffered and written and
+	 * synced a batch at a time. A log is only ever started or cut by writing a new
+	 * file next to it and renaming it into place, so a crash leaves either the old
+	 * log or the new one. Once a write or sync fails the log is missing mutations, so
+	 * it stays failed, dropping later records, until reset starts a new one. Neither a
+	 * copy of a graph nor a graph assigned to writes to the log.
+	 */
+	class journal {
+	private:
+		std::FILE*   file;
+		std::string  path;
+		vector<char> buffer;
+		std::size_t  batch;   // records per write
+		std::size_t  pending; // records in buffer
+		bool         failed;  // a write or sync failed since the log was started
+
+	public:
+		unsigned long long generation; // snapshot this log continues from
+
+		journal () : file(0), batch(1), pending(0), failed(false), generation(0) {}
+
+		journal (const journal& that) : file(0), batch(1), pending(0), failed(false), generation(that.generation) {}
+
+		journal& operator = (const journal& that) {
+			close();
+			failed     = false;
+			generation = that.generation;
+			return *this;}
+
+		~journal () {
+			close();}
+
+		bool is_open () const {
+			return file != 0;}
+
+		// size of the header: "GLOG" and the generation
+		static const std::size_t head = 4 + sizeof(unsigned long long);
+
+		// the header of a log continuing generation gen
+		static vector<char> header (unsigned long long gen) {
+			vector<char> bytes("GLOG", "GLOG" + 4);
+			bytes.insert(bytes.end(), (const char*)&gen, (const char*)&gen + sizeof(gen));
+			return bytes;}
+
+		// replaces p with the first n bytes of data, through a synced temporary file
+		static bool replace (const std::string& p, const char* data, std::size_t n) {
+			const std::string tmp = p + ".tmp";
+			std::FILE*        f   = std::fopen(tmp.c_str(), "wb");
+			if (!f)
+				return false;
+			bool ok = std::fwrite(data, 1, n, f) == n;
+			ok = std::fflush(f) == 0 && ok;
+#if defined(__unix__) || defined(__APPLE__)
+			ok = fsync(fileno(f)) == 0 && ok;
+#endif
+			ok = std::fclose(f) == 0 && ok;
+			if (!ok || std::rename(tmp.c_str(), p.c_str()) != 0) {
+				std::remove(tmp.c_str());
+				return false;}
+			return true;}
+
+		// opens p for appending; starts a new log if reset, or if p is missing, shorter
+		// than a header or from another generation, and refuses a file that is not a log
+		// or, unless reset, a log that failed
+		bool open (const std::string& p, std::size_t n, bool reset) {
+			close();
+			if (failed && !reset)
+				return false;
+			char first[head];
+			std::size_t got = 0;
+			if (std::FILE* f = std::fopen(p.c_str(), "rb")) {
+				got = std::fread(first, 1, head, f);
+				std::fclose(f);}
+			if (!reset && got == head && std::memcmp(first, "GLOG", 4) != 0)
+				return false;
+			unsigned long long gen = 0;
+			if (got == head)
+				std::memcpy(&gen, first + 4, sizeof(gen));
+			if (reset || got < head || gen != generation) {
+				const vector<char> bytes = header(generation);
+				if (!replace(p, &bytes[0], bytes.size()))
+					return false;}
+			file = std::fopen(p.c_str(), "ab");
+			if (!file)
+				return false;
+			path   = p;
+			batch  = std::max<std::size_t>(1, n);
+			failed = false;
+			return true;}
+
+		// starts an empty log for the current generation; a closed log is left for
+		// open to restart, since its generation is now stale
+		bool reset () {
+			if (!file) {
+				failed = false;
+				return true;}
+			return open(path, batch, true);}
+
+		void record (char op, int a, int b) {
+			if (!file || failed)
+				return;
+			buffer.push_back(op);
+			buffer.insert(buffer.end(), (const char*)&a, (const char*)&a + sizeof(a));
+			buffer.insert(buffer.end(), (const char*)&b, (const char*)&b + sizeof(b));
+			if (++pending >= batch)
+				flush();}
+
+		// group commit: one write and one sync for every buffered record; returns
+		// false if this or an earlier commit failed
+		bool flush () {
+			if (!file || buffer.empty() || failed) {
+				buffer.clear();
+				pending = 0;
+				return !failed;}
+			bool ok = std::fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+			ok = std::fflush(file) == 0 && ok;
+#if defined(__unix__) || defined(__APPLE__)
+			ok = fsync(fileno(file)) == 0 && ok;
+#endif
+			buffer.clear();
+			pending = 0;
+			failed  = !ok;
+			return ok;}
+
+		bool close () {
+			if (!file)
+				return !failed;
+			bool ok = flush();
+			ok = std::fclose(file) == 0 && ok;
+			file   = 0;
+			failed = !ok;
+			return ok;}};
+
+public:
+	// ------------
+	// property_map
+	// ------------
+
+	/**
+	 * Handle on a property column of a graph, keyed by vertex descriptor for vertex
+	 * properties and by edge descriptor for edge properties. The column grows with the
+	 * graph; a copy of the graph has its own columns, so the handle keeps referring
+	 * to the graph it came from.
+	 */
+	template <typename T>
+	class property_map {
+	private:
+		typed_column<T>* c;
+
+	public:
+		typedef T           value_type;
+		typedef std::size_t key_type;
+
+		explicit property_map (typed_column<T>* p) : c(p) {}
+
+		/**
+		 * @param k - key
+		 * @return reference
+		 * returns the value of key k
+		 */
+		typename vector<T>::reference operator [] (key_type k) const {
+			assert(k < c->data.size());
+			return c->data[k];}
+
+		/**
+		 * @return vector<T>&
+		 * returns the whole column, for algorithms that scan it
+		 */
+		vector<T>& values () const {
+			return c->data;}
+
+		/**
+		 * @param pm - property map
+		 * @param k - key
+		 * @return const_reference
+		 * returns the value of key k
+		 */
+		friend typename vector<T>::const_reference get (const property_map& pm, key_type k) {
+			assert(k < pm.c->data.size());
+			return pm.c->data[k];}
+
+		/**
+		 * @param pm - property map
+		 * @param k - key
+		 * @param v - value
+		 * sets the value of key k to v
+		 */
+		friend void put (const property_map& pm, key_type k, const T& v) {
+			assert(k < pm.c->data.size());
+			pm.c->data[k] = v;}};
+
 
 private:
 	// ----
@@ -50,8 +441,25 @@ private:
 
 	map< vertex_descriptor, vector<vertex_descriptor> > graph;
 	map< vertices_size_type, vertex_descriptor> vertices; // vertices and its edges
+	vector<vertex_descriptor> listed; // the keys of vertices in order, for vertex_iterator
 
-	map< edge_descriptor, pair<vertex_descriptor, vertex_descriptor> > edges; // edges
+	vector< pair<vertex_descriptor, vertex_descriptor> > ends; // endpoints of each edge, by edge descriptor
+
+	map< vertex_descriptor, vector<edges_size_type> > edge_ids; // edge descriptor of each entry of graph
+	edges_size_type eid; // descriptor of the next edge
+
+	map< vertex_descriptor, vector<std::uint64_t> > hubs; // bitmap of the targets of each hub
+	vertices_size_type hub_degree; // out-degree at which a vertex gets a bitmap
+
+	bool dag; // whether add_edge refuses edges that close a cycle
+	map< vertex_descriptor, vector<vertex_descriptor> > parents; // in-neighbors, kept in DAG mode
+	map< vertex_descriptor, vertices_size_type> position; // index of each vertex in order
+	vector<vertex_descriptor> order; // topological order, kept in DAG mode
+
+	columns vertex_columns; // one slot per vertex descriptor
+	columns edge_columns;   // one slot per edge index
+
+	journal wal; // mutation log, closed unless open_log was called
 
 	vertex_descriptor vid;
 
@@ -68,35 +476,38 @@ public:
 	 * @return std::pair<edge_descriptor, bool>
 	 * Adds edge (u,v) to the graph and returns the edge descriptor for the new edge. For graphs that do 
 	 * not allow parallel edges, if the edge is already in the graph then a duplicate will not be added and the bool flag will be false. When the flag is false, the returned edge descriptor points to the already existing edge.
+	 * In DAG mode an edge that would close a cycle is not added either; the flag is false and the edge descriptor is arbitrary.
+	 * Negative descriptors are not vertices (-1 marks a missing vertex elsewhere), so an edge with a negative endpoint is rejected the same way.
 	 */
 	friend std::pair<edge_descriptor, bool> add_edge (vertex_descriptor a, vertex_descriptor b, Graph& g) {
 
-		edge_descriptor ed = (edge_descriptor)10 * a  + b;
-		bool            add_edge  = true;
-		for ( auto it = g.edges.begin(); it != g.edges.end(); ++it ){
-			if( (it->second.first  == a && it->second.second == b)  )  {
-				add_edge= false;
-			}
-		}
-		if(add_edge){
-
-			g.edges[ed] = make_pair(a,b);
-			if(g.graph.find(a) == g.graph.end()){
-				g.graph[a] = {};
-				g.graph[a].push_back(b);
-			}
-			else{
-				g.graph[a].push_back(b);
-			}
-
-		}
-		else{
+		if (a < 0 || b < 0)
+			return std::make_pair(0, false);
+		edge_descriptor ed = (edge_descriptor)g.eid;
+		if (g.has_edge(a, b)) {
 			std::pair<edge_descriptor, bool> found =edge(a, b, g); 
-			ed = found.first;      
+			return std::make_pair(found.first, false);
+		}
+		if (g.dag) {
+			if (a == b)
+				return std::make_pair(0, false); // refused before adopting, so g is unchanged
+			g.adopt(a);
+			g.adopt(b);
+			if (!g.keep_order(a, b))
+				return std::make_pair(0, false);
+			g.parents[b].push_back(a);
 		}
 
-		sort(g.graph[a].begin(),g.graph[a].end());
-		return std::make_pair(ed, add_edge);
+		g.ends.push_back(make_pair(a, b));
+		vector<vertex_descriptor>& row = g.graph[a];
+		auto                       at  = lower_bound(row.begin(), row.end(), b);
+		g.edge_ids[a].insert(g.edge_ids[a].begin() + (at - row.begin()), g.eid);
+		row.insert(at, b);
+		g.vertex_columns.grow((std::size_t)std::max(a, b) + 1);
+		g.edge_columns.grow(++g.eid);
+		g.index_hub(a, b);
+		g.wal.record('e', a, b);
+		return std::make_pair(ed, true);
 	}
 
 
@@ -112,9 +523,10 @@ public:
 	 * returns the vertex_descriptor of the added vertex
 	 */
 	friend vertex_descriptor add_vertex (Graph& g) {
-		g.vertices[(vertices_size_type)g.vid] = g.vid;
 		vertex_descriptor v  =  g.vid;       
 		++g.vid;
+		g.adopt(v);
+		g.wal.record('a', 0, 0);
 		return v;}
 
 
@@ -130,20 +542,16 @@ public:
 	 * @return bool
 	 * If an edge from vertex a to vertex b exists, return a pair containing one such edge and true. 
 	 * If there are no edges between a and b, return a pair with an arbitrary edge descriptor and false.
+	 * The edge a -> b is preferred over b -> a. Ruling an edge out is a bit test when the source is a
+	 * hub and a binary search of its sorted adjacency list otherwise; finding the descriptor of an
+	 * edge that exists is a binary search of that list, O(log degree).
 	 */
 	friend std::pair<edge_descriptor, bool> edge (vertex_descriptor a, vertex_descriptor b, const Graph& g) {
-		bool            exist  = false;
-		edge_descriptor ed = 0;
-
-
-		for ( auto it = g.edges.begin(); it != g.edges.end(); ++it ){
-			if( (it->second.first  == a && it->second.second == b) ||
-					(it->second.first  == b && it->second.second == a) )  {
-				exist= true;
-				ed = it->first;
-			}
-		}
-		return std::make_pair(ed, exist);}
+		if (g.has_edge(a, b))
+			return std::make_pair((edge_descriptor)edge_index(a, b, g).first, true);
+		if (g.has_edge(b, a))
+			return std::make_pair((edge_descriptor)edge_index(b, a, g).first, true);
+		return std::make_pair(0, false);}
 
 
 
@@ -157,7 +565,7 @@ public:
 	 *Returns the number of edges in the graph g.
 	 */
 	friend edges_size_type num_edges (const Graph& g) {
-		edges_size_type s = (edges_size_type) g.edges.size() ; 
+		edges_size_type s = (edges_size_type) g.ends.size() ; 
 		return s;}
 
 	// ------------
@@ -184,7 +592,7 @@ public:
 	 * Returns the source vertex of edge ed.
 	 */
 	friend vertex_descriptor source (edge_descriptor ed, const Graph& g) {
-		vertex_descriptor v =  g.edges.at(ed).first; 
+		vertex_descriptor v =  g.ends.at(ed).first; 
 		return v;}
 
 	// ------
@@ -198,7 +606,7 @@ public:
 	 * Returns the target vertex of edge ed.
 	 */
 	friend vertex_descriptor target (edge_descriptor ed, const Graph& g) {
-		vertex_descriptor v = g.edges.at(ed).second;
+		vertex_descriptor v = g.ends.at(ed).second;
 		return v;}
 
 	// ------
@@ -215,7 +623,8 @@ public:
 		auto it_vd = g.vertices.find(n);
 		vertex_descriptor vd = n ;
 		if(it_vd == g.vertices.end()){
-			g.vertices[n]= vd;
+			g.adopt(vd);
+			g.wal.record('n', vd, 0);
 		}
 		else{
 			vd = it_vd -> second; 
@@ -233,6 +642,11 @@ public:
 		// typedefs
 		// --------
 		typedef typename Graph::vertices_size_type           size_type;
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef vertex_descriptor               value_type;
+		typedef std::ptrdiff_t                  difference_type;
+		typedef vertex_descriptor*              pointer;
+		typedef vertex_descriptor&              reference;
 
 	public:
 		// -----------
@@ -243,10 +657,10 @@ public:
 		 * @param lhs - vertex_iterator left hand side of operation
 		 * @param rhs - vertex_iterator right hand side of operation
 		 * @return bool
-		 * returns whether two iterators iterate over same container
+		 * returns whether two iterators are at the same position of the same graph
 		 */
 		friend bool operator == (const vertex_iterator& lhs, const vertex_iterator& rhs) {
-			return *lhs == *rhs;
+			return lhs._c == rhs._c && lhs.index == rhs.index;
 		}
 
 		/**
@@ -258,6 +672,62 @@ public:
 		friend bool operator != (const vertex_iterator& lhs, const vertex_iterator& rhs) {
 			return !(lhs == rhs);}
 
+		// ----------
+		// operator <
+		// ----------
+
+		/**
+		 * @param lhs - vertex_iterator left hand side of operation
+		 * @param rhs - vertex_iterator right hand side of operation
+		 * @return bool
+		 * returns whether lhs is before rhs
+		 */
+		friend bool operator < (const vertex_iterator& lhs, const vertex_iterator& rhs) {
+			return lhs.index < rhs.index;}
+
+		friend bool operator > (const vertex_iterator& lhs, const vertex_iterator& rhs) {
+			return rhs < lhs;}
+
+		friend bool operator <= (const vertex_iterator& lhs, const vertex_iterator& rhs) {
+			return !(rhs < lhs);}
+
+		friend bool operator >= (const vertex_iterator& lhs, const vertex_iterator& rhs) {
+			return !(lhs < rhs);}
+
+		// ---------------
+		// operator + / -
+		// ---------------
+
+		/**
+		 * @param lhs - vertex_iterator left hand side of operation
+		 * @param rhs - vertex_iterator right hand side of operation
+		 * @return difference_type
+		 * returns the number of steps from rhs to lhs
+		 */
+		friend difference_type operator - (const vertex_iterator& lhs, const vertex_iterator& rhs) {
+			return (difference_type)lhs.index - (difference_type)rhs.index;}
+
+		/**
+		 * @param x - vertex_iterator
+		 * @param d - number of steps
+		 * @return vertex_iterator
+		 * returns x moved d steps forward
+		 */
+		friend vertex_iterator operator + (vertex_iterator x, difference_type d) {
+			return x += d;}
+
+		friend vertex_iterator operator + (difference_type d, vertex_iterator x) {
+			return x += d;}
+
+		/**
+		 * @param x - vertex_iterator
+		 * @param d - number of steps
+		 * @return vertex_iterator
+		 * returns x moved d steps backward
+		 */
+		friend vertex_iterator operator - (vertex_iterator x, difference_type d) {
+			return x -= d;}
+
 
 
 	private:
@@ -287,6 +757,8 @@ public:
 		 * @param index i
 		 * construct a vertex_iterator for _c starting at i
 		 */
+		vertex_iterator () : _c(0), index(0) {}
+
 		vertex_iterator (Graph* c, size_type i = 0) : _c(c), index(0){
 
 			index = i;
@@ -306,10 +778,24 @@ public:
 		/**
 		 * @param vertex_iterator
 		 * @return reference - vertex_descriptor&
-		 * dereferences vertex_iterator
+		 * dereferences vertex_iterator; vertices are in descriptor order, so the
+		 * vertex at position i is the i-th smallest descriptor
 		 */
 		vertex_descriptor& operator * () const {
-			return (*_c).vertices[index];}
+			assert(index < (*_c).listed.size());
+			return (*_c).listed[index];}
+
+		// ------------
+		// operator []
+		// ------------
+
+		/**
+		 * @param d - number of steps
+		 * @return reference - vertex_descriptor&
+		 * dereferences the vertex_iterator d steps away
+		 */
+		vertex_descriptor& operator [] (difference_type d) const {
+			return *(*this + d);}
 
 		// -----------
 		// operator ->
@@ -380,7 +866,7 @@ public:
 		 * @return vertex_iterator reference
 		 * adds d to iterator
 		 */
-		vertex_iterator& operator += (vertices_size_type d) {
+		vertex_iterator& operator += (difference_type d) {
 
 			index += d;
 			assert(valid());
@@ -396,7 +882,7 @@ public:
 		 * @return vertex_iterator reference
 		 * subtracts d from iterator
 		 */
-		vertex_iterator& operator -= (vertices_size_type d) {
+		vertex_iterator& operator -= (difference_type d) {
 			index -= d;
 			assert(valid());
 			return *this;
@@ -428,10 +914,10 @@ public:
 		 * @param lhs - edge iterator left hand side of operation
 		 * @param rhs - edge iterator right hand side of operation
 		 * @return bool
-		 * returns whether two iterators iterate over same container
+		 * returns whether two iterators are at the same position of the same graph
 		 */
 		friend bool operator == (const edge_iterator& lhs, const edge_iterator& rhs) {
-			return *lhs == *rhs;
+			return lhs._c == rhs._c && lhs.index == rhs.index;
 		}
 
 		/**
@@ -453,6 +939,8 @@ public:
 
 		Graph* _c;
 		size_type index;
+		typename map< vertex_descriptor, vector<vertex_descriptor> >::const_iterator row; // row of the current edge
+		size_type at; // position of the current edge in row
 
 	private:
 		// -----
@@ -462,6 +950,12 @@ public:
 		bool valid () const {
 			return index >= 0;}
 
+		// moves past rows that have no edge at or after at
+		void settle () {
+			while (row != _c->graph.end() && at >= row->second.size()) {
+				at -= row->second.size();
+				++row;}}
+
 	public:
 		// -----------
 		// constructor
@@ -472,9 +966,10 @@ public:
 		 * @param index i
 		 * construct a edge_iterator for _c starting at i
 		 */
-		edge_iterator (Graph* c, size_type i = 0) : _c(c), index(0){
+		edge_iterator (Graph* c, size_type i = 0) : _c(c), index(0), row(c->graph.begin()), at(i){
 
 			index = i;
+			settle();
 
 			assert(valid());
 		}
@@ -491,14 +986,10 @@ public:
 		/**
 		 * @param edge_iterator
 		 * @return edge_descriptor
-		 * dereferences edge_iterator
+		 * dereferences edge_iterator; edges are listed by source, then by target
 		 */
 		edge_descriptor operator * () const {
-			edge_descriptor r =0;
-			auto it = (*_c).edges.begin();
-			advance(it, index);
-			r= it->first;
-			return r;
+			return (edge_descriptor)_c->edge_ids.find(row->first)->second[at];
 		}
 
 
@@ -514,6 +1005,8 @@ public:
 		 */
 		edge_iterator& operator ++ () {
 			++index;
+			++at;
+			settle();
 			assert(valid());
 			return *this;}
 
@@ -539,6 +1032,8 @@ public:
 		edge_iterator& operator += (edges_size_type d) {
 
 			index += d;
+			at    += d;
+			settle();
 			assert(valid());
 			return *this;}
 
@@ -561,6 +1056,11 @@ public:
 		// --------
 
 		typedef typename Graph::vertices_size_type           size_type;
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef vertex_descriptor               value_type;
+		typedef std::ptrdiff_t                  difference_type;
+		typedef vertex_descriptor*              pointer;
+		typedef vertex_descriptor&              reference;
 
 	public:
 		// -----------
@@ -586,6 +1086,62 @@ public:
 		friend bool operator != (const adjacency_iterator& lhs, const adjacency_iterator& rhs) {
 			return !(lhs == rhs);}
 
+		// ----------
+		// operator <
+		// ----------
+
+		/**
+		 * @param lhs - adjacency_iterator left hand side of operation
+		 * @param rhs - adjacency_iterator right hand side of operation
+		 * @return bool
+		 * returns whether lhs is before rhs
+		 */
+		friend bool operator < (const adjacency_iterator& lhs, const adjacency_iterator& rhs) {
+			return lhs.index < rhs.index;}
+
+		friend bool operator > (const adjacency_iterator& lhs, const adjacency_iterator& rhs) {
+			return rhs < lhs;}
+
+		friend bool operator <= (const adjacency_iterator& lhs, const adjacency_iterator& rhs) {
+			return !(rhs < lhs);}
+
+		friend bool operator >= (const adjacency_iterator& lhs, const adjacency_iterator& rhs) {
+			return !(lhs < rhs);}
+
+		// ---------------
+		// operator + / -
+		// ---------------
+
+		/**
+		 * @param lhs - adjacency_iterator left hand side of operation
+		 * @param rhs - adjacency_iterator right hand side of operation
+		 * @return difference_type
+		 * returns the number of steps from rhs to lhs
+		 */
+		friend difference_type operator - (const adjacency_iterator& lhs, const adjacency_iterator& rhs) {
+			return (difference_type)lhs.index - (difference_type)rhs.index;}
+
+		/**
+		 * @param x - adjacency_iterator
+		 * @param d - number of steps
+		 * @return adjacency_iterator
+		 * returns x moved d steps forward
+		 */
+		friend adjacency_iterator operator + (adjacency_iterator x, difference_type d) {
+			return x += d;}
+
+		friend adjacency_iterator operator + (difference_type d, adjacency_iterator x) {
+			return x += d;}
+
+		/**
+		 * @param x - adjacency_iterator
+		 * @param d - number of steps
+		 * @return adjacency_iterator
+		 * returns x moved d steps backward
+		 */
+		friend adjacency_iterator operator - (adjacency_iterator x, difference_type d) {
+			return x -= d;}
+
 
 
 	private:
@@ -597,6 +1153,7 @@ public:
 		Graph* _c;
 		size_type index;
 		vertex_descriptor _vd;
+		vector<vertex_descriptor>* _row; // adjacency list of _vd
 
 	private:
 		// -----
@@ -617,7 +1174,7 @@ public:
 		 * @param index vd
 		 * construct a adjacency_iterator for _c starting at vd starting at i
 		 */
-		adjacency_iterator (Graph* c, size_type i = 0, vertex_descriptor vd = 0) : _c(c), index(0), _vd(vd){
+		adjacency_iterator (Graph* c, size_type i = 0, vertex_descriptor vd = 0) : _c(c), index(0), _vd(vd), _row(&c->graph[vd]){
 
 			index = i;
 
@@ -625,6 +1182,8 @@ public:
 			assert(valid());
 		}
 
+		adjacency_iterator () : _c(0), index(0), _vd(0), _row(0) {}
+
 		// Default copy, destructor, and copy assignment.
 		// iterator (const iterator&);
 		// ~iterator ();
@@ -640,9 +1199,21 @@ public:
 		 * dereferences adjacency_iterator
 		 */
 		vertex_descriptor& operator * () const {                   
-			return (*_c).graph[_vd][index];
+			return (*_row)[index];
 		}
 
+		// ------------
+		// operator []
+		// ------------
+
+		/**
+		 * @param d - number of steps
+		 * @return vertex_descriptor
+		 * dereferences the adjacency_iterator d steps away
+		 */
+		vertex_descriptor& operator [] (difference_type d) const {
+			return (*_row)[index + d];}
+
 
 
 		// -----------
@@ -700,6 +1271,36 @@ public:
 			assert(valid());
 			return x;}
 
+		// -----------
+		// operator +=
+		// -----------
+
+		/**
+		 * @param adjacency_iterator
+		 * @param value d
+		 * @return adjacency_iterator reference
+		 * adds d to adjacency_iterator
+		 */
+		adjacency_iterator& operator += (difference_type d) {
+			index += d;
+			assert(valid());
+			return *this;}
+
+		// -----------
+		// operator -=
+		// -----------
+
+		/**
+		 * @param adjacency_iterator
+		 * @param value d
+		 * @return adjacency_iterator reference
+		 * subtracts d from adjacency_iterator
+		 */
+		adjacency_iterator& operator -= (difference_type d) {
+			index -= d;
+			assert(valid());
+			return *this;}
+
 
 
 
@@ -786,7 +1387,7 @@ public:
 	 * returns edge_iterator to one index past the last element in the edges set
 	 */
 	edge_iterator edge_end () {
-		return edge_iterator(this, edges.size());
+		return edge_iterator(this, ends.size());
 	}  
 
 
@@ -815,6 +1416,1388 @@ public:
 
 
 
+	// ---
+	// csr
+	// ---
+
+	/**
+	 * Compressed sparse row snapshot of the adjacency lists. Vertices are
+	 * numbered densely in vertex-iterator order; the neighbors of dense vertex
+	 * i are targets[offsets[i]] .. targets[offsets[i + 1] - 1], also dense.
+	 */
+	struct csr {
+		vector<vertex_descriptor> vertices; // dense index -> vertex descriptor
+		vector<std::size_t>       offsets;  // num_vertices + 1 row offsets
+		vector<std::size_t>       targets;  // dense neighbor indices
+	};
+
+	// ------------
+	// query_engine
+	// ------------
+
+	/**
+	 * Answers batches of neighborhood and induced-subgraph queries against one CSR
+	 * snapshot of a graph. The snapshot, the worker threads and each worker's visited
+	 * marks and frontier buffers are built once and reused by every batch, so a batch
+	 * allocates only its results. Later changes to the graph are not seen; build a new
+	 * engine to pick them up. One batch runs at a time.
+	 */
+	class query_engine {
+	private:
+		struct scratch {
+			vector<std::uint64_t>         seen;     // bit i: query i of the group has reached v
+			vector<std::uint64_t>         fresh;    // bits that reached v at the current hop
+			vector<std::uint64_t>         gain;     // bits that reach v at the next hop
+			vector< vector<std::size_t> > members;  // vertices of each query of the group
+			vector<std::size_t>           frontier; // vertices with fresh bits
+			vector<std::size_t>           next;     // vertices with gained bits
+			vector<std::size_t>           local;    // dense index -> local index in the current answer
+			vector<std::size_t>           row;};
+
+		csr                 out;
+		vector<std::size_t> index; // vertex descriptor -> dense index
+		thread_pool         pool;
+		vector<scratch>     scratches;
+
+	public:
+		/**
+		 * @param g - Adjacency list
+		 * @param threads - number of worker threads, 0 for one per hardware thread
+		 */
+		explicit query_engine (const Graph& g, std::size_t threads = 0) : out(g.compress(false)), pool(threads), scratches(pool.size()) {
+			for (std::size_t i = 0; i < out.vertices.size(); ++i) {
+				if ((std::size_t)out.vertices[i] >= index.size())
+					index.resize(out.vertices[i] + 1, std::size_t(-1));
+				index[out.vertices[i]] = i;}}
+
+		/**
+		 * @param sources - one query per source
+		 * @param k - number of hops
+		 * @return vector<csr>
+		 * See neighborhoods.
+		 */
+		vector<csr> neighborhoods (const vector<vertex_descriptor>& sources, std::size_t k) {
+			vector< vector<vertex_descriptor> > queries;
+			for (std::size_t i = 0; i < sources.size(); ++i)
+				queries.push_back(vector<vertex_descriptor>(1, sources[i]));
+			return run(queries, k);}
+
+		/**
+		 * @param sets - one query per vertex set
+		 * @return vector<csr>
+		 * See induced_subgraphs.
+		 */
+		vector<csr> induced_subgraphs (const vector< vector<vertex_descriptor> >& sets) {
+			return run(sets, 0);}
+
+	private:
+		/**
+		 * @param queries - seed vertex sets
+		 * @param k - number of out-hops to expand each seed set by
+		 * @return vector<csr>
+		 * Answers every query of the batch. Identical queries are answered once. The rest
+		 * are expanded in groups of up to 64 by one multi-source BFS that keeps a bitmask
+		 * of queries per vertex, so a row shared by several queries of a group is read
+		 * once per hop. Threads take groups one at a time.
+		 */
+		vector<csr> run (const vector< vector<vertex_descriptor> >& queries, std::size_t k) {
+			const std::size_t n = out.vertices.size();
+
+			map<vector<vertex_descriptor>, std::size_t> first; // query -> its answer
+			vector<std::size_t>                         unique;
+			vector<std::size_t>                         slot(queries.size());
+			for (std::size_t q = 0; q < queries.size(); ++q) {
+				auto it = first.insert(make_pair(queries[q], unique.size())).first;
+				if (it->second == unique.size())
+					unique.push_back(q);
+				slot[q] = it->second;}
+
+			// narrow groups when there are few queries so every thread gets one
+			const std::size_t        width  = std::max<std::size_t>(1, std::min<std::size_t>(64, (unique.size() + pool.size() - 1) / pool.size()));
+			const std::size_t        groups = (unique.size() + width - 1) / width;
+			vector<csr>              answers(unique.size());
+			std::atomic<std::size_t> next(0);
+			pool.run([&] (std::size_t t) {
+				scratch& s = scratches[t];
+				if (s.seen.size() != n) {
+					s.seen.assign(n, 0);
+					s.fresh.assign(n, 0);
+					s.gain.assign(n, 0);
+					s.local.resize(n);}
+				for (std::size_t group; (group = next++) < groups; ) {
+					const std::size_t lo = group * width;
+					const std::size_t hi = std::min(lo + width, unique.size());
+					expand(s, queries, unique, lo, hi, k);
+					for (std::size_t u = lo; u < hi; ++u)
+						answer(s, s.members[u - lo], std::uint64_t(1) << (u - lo), answers[u]);
+					for (std::size_t i = 0; i < hi - lo; ++i)
+						for (std::size_t j = 0; j < s.members[i].size(); ++j)
+							s.seen[s.members[i][j]] = 0;}});
+
+			vector<csr> results(queries.size());
+			for (std::size_t q = 0; q < queries.size(); ++q)
+				results[q] = answers[slot[q]];
+			return results;}
+
+		/**
+		 * @param s - scratch of the calling thread, with seen, fresh and gain all zero
+		 * @param queries - seed vertex sets
+		 * @param unique - the queries to answer
+		 * @param lo - first query of the group in unique
+		 * @param hi - one past the last query of the group in unique
+		 * @param k - number of out-hops
+		 * Fills s.members[i] with the vertices within k hops of the seeds of query lo + i:
+		 * the seeds as listed, then each hop in dense order. Leaves fresh and gain zero.
+		 */
+		void expand (scratch& s, const vector< vector<vertex_descriptor> >& queries, const vector<std::size_t>& unique, std::size_t lo, std::size_t hi, std::size_t k) const {
+			const std::size_t npos = std::size_t(-1);
+			s.members.resize(std::max(s.members.size(), hi - lo));
+			s.frontier.clear();
+			for (std::size_t i = 0; i < hi - lo; ++i) {
+				const vector<vertex_descriptor>& seeds = queries[unique[lo + i]];
+				const std::uint64_t              bit   = std::uint64_t(1) << i;
+				s.members[i].clear();
+				for (std::size_t j = 0; j < seeds.size(); ++j) {
+					const std::size_t v = seeds[j] >= 0 && (std::size_t)seeds[j] < index.size() ? index[seeds[j]] : npos;
+					if (v == npos || (s.seen[v] & bit))
+						continue;
+					s.seen[v] |= bit;
+					s.members[i].push_back(v);
+					if (!s.fresh[v])
+						s.frontier.push_back(v);
+					s.fresh[v] |= bit;}}
+
+			for (std::size_t hop = 0; hop < k && !s.frontier.empty(); ++hop) {
+				s.next.clear();
+				for (std::size_t i = 0; i < s.frontier.size(); ++i) {
+					const std::size_t   v    = s.frontier[i];
+					const std::uint64_t bits = s.fresh[v];
+					s.fresh[v] = 0;
+					for (std::size_t e = out.offsets[v]; e < out.offsets[v + 1]; ++e) {
+						const std::size_t   w   = out.targets[e];
+						const std::uint64_t add = bits & ~s.seen[w];
+						if (!add)
+							continue;
+						s.seen[w] |= add;
+						if (!s.gain[w])
+							s.next.push_back(w);
+						s.gain[w] |= add;}}
+				std::sort(s.next.begin(), s.next.end());
+				for (std::size_t i = 0; i < s.next.size(); ++i) {
+					const std::size_t w = s.next[i];
+					for (std::uint64_t b = s.gain[w]; b != 0; b &= b - 1)
+						s.members[lowest_bit(b)].push_back(w);}
+				s.fresh.swap(s.gain);
+				s.frontier.swap(s.next);}
+			for (std::size_t i = 0; i < s.frontier.size(); ++i)
+				s.fresh[s.frontier[i]] = 0;}
+
+		/**
+		 * @param b - nonzero mask
+		 * @return std::size_t
+		 * returns the index of the lowest set bit of b, by de Bruijn multiplication
+		 */
+		static std::size_t lowest_bit (std::uint64_t b) {
+			static const unsigned char at[64] = {
+				 0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+				62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+				63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+				46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6};
+			return at[((b & (0 - b)) * 0x03f79d71b4cb0a89ULL) >> 58];}
+
+		/**
+		 * @param s - scratch of the calling thread, after expand
+		 * @param members - vertices of one query, in local order
+		 * @param bit - the bit of the query in s.seen
+		 * @param c - output, the subgraph induced by members
+		 */
+		void answer (scratch& s, const vector<std::size_t>& members, std::uint64_t bit, csr& c) const {
+			for (std::size_t i = 0; i < members.size(); ++i)
+				s.local[members[i]] = i;
+			c.vertices.resize(members.size());
+			c.offsets.assign(1, 0);
+			for (std::size_t i = 0; i < members.size(); ++i) {
+				const std::size_t v = members[i];
+				c.vertices[i] = out.vertices[v];
+				s.row.clear();
+				for (std::size_t e = out.offsets[v]; e < out.offsets[v + 1]; ++e)
+					if (s.seen[out.targets[e]] & bit)
+						s.row.push_back(s.local[out.targets[e]]);
+				std::sort(s.row.begin(), s.row.end());
+				c.targets.insert(c.targets.end(), s.row.begin(), s.row.end());
+				c.offsets.push_back(c.targets.size());}}};
+
+	// -------------
+	// neighborhoods
+	// -------------
+
+	/**
+	 * @param g - Adjacency list
+	 * @param sources - one query per source
+	 * @param k - number of hops
+	 * @param threads - number of worker threads, 0 for one per hardware thread
+	 * @return vector<csr>
+	 * For each source, returns the subgraph induced by the vertices within k out-hops
+	 * of it. Local vertex 0 is the source and the rest follow hop by hop, each hop in
+	 * vertex order. Builds a query_engine for the one batch; keep a query_engine to
+	 * answer many batches.
+	 */
+	friend vector<csr> neighborhoods (const Graph& g, const vector<vertex_descriptor>& sources, std::size_t k, std::size_t threads = 0) {
+		return query_engine(g, threads).neighborhoods(sources, k);}
+
+	// -----------------
+	// induced_subgraphs
+	// -----------------
+
+	/**
+	 * @param g - Adjacency list
+	 * @param sets - one query per vertex set
+	 * @param threads - number of worker threads, 0 for one per hardware thread
+	 * @return vector<csr>
+	 * For each set, returns the subgraph induced by its vertices, numbered in the order
+	 * they are listed. Repeats and descriptors that are not vertices are left out.
+	 * Builds a query_engine for the one batch; keep a query_engine to answer many batches.
+	 */
+	friend vector<csr> induced_subgraphs (const Graph& g, const vector< vector<vertex_descriptor> >& sets, std::size_t threads = 0) {
+		return query_engine(g, threads).induced_subgraphs(sets);}
+
+	// ------------
+	// walk_options
+	// ------------
+
+	/**
+	 * Settings for random_walks. With p = q = 1 the walks are first order; otherwise
+	 * they follow node2vec, weighting a step back to the previous vertex by 1 / p, a
+	 * step to a neighbor of the previous vertex by 1 and any other step by 1 / q.
+	 * p and q must be positive and finite: a zero or infinite weight can leave a
+	 * vertex with no step that is ever accepted.
+	 */
+	struct walk_options {
+		double                        p;          // return parameter, in (0, inf)
+		double                        q;          // in-out parameter, in (0, inf)
+		const property_map<double>*   weights;    // edge weights by edge descriptor, 0 for unweighted
+		vertices_size_type            hub_degree; // out-degree from which weighted rows get an alias table
+		std::size_t                   threads;    // worker threads, 0 for one per hardware thread
+		std::size_t                   batch;      // walks per write when streaming to a file
+		unsigned long long            seed;
+
+		walk_options () : p(1), q(1), weights(0), hub_degree(32), threads(0), batch(1 << 16), seed(1) {}};
+
+	// ------------
+	// random_walks
+	// ------------
+
+	/**
+	 * @param g - Adjacency list
+	 * @param starts - first vertex of each walk
+	 * @param length - number of vertices in each walk
+	 * @param out - output, walk i is out[i * length] .. out[(i + 1) * length - 1]
+	 * @param options - walk_options
+	 * @return std::size_t
+	 * Runs one walk from each start in parallel and returns the number of steps taken.
+	 * A walk that reaches a vertex without out-edges, or starts at a descriptor that is
+	 * not a vertex, is padded with -1. Each walk draws from its own generator seeded by
+	 * options.seed and its position in starts, so the output does not depend on the
+	 * number of threads. out keeps its storage when it is already large enough.
+	 */
+	friend std::size_t random_walks (const Graph& g, const vector<vertex_descriptor>& starts, std::size_t length, vector<vertex_descriptor>& out, const walk_options& options = walk_options()) {
+		const walk_engine w(g, options);
+		thread_pool       pool(options.threads);
+		out.resize(starts.size() * length);
+		return w.run(pool, starts, 0, starts.size(), length, out.empty() ? 0 : &out[0]);}
+
+	/**
+	 * @param g - Adjacency list
+	 * @param starts - first vertex of each walk
+	 * @param length - number of vertices in each walk
+	 * @param f - binary output, walks one after another as 32-bit descriptors
+	 * @param options - walk_options
+	 * @return std::size_t
+	 * Same as above, but runs options.batch walks at a time through one reused buffer
+	 * and writes each batch to f. Returns the number of steps written. Stops at the
+	 * first batch that f does not take in full, leaving the error set on f, and counts
+	 * only the batches before it.
+	 */
+	friend std::size_t random_walks (const Graph& g, const vector<vertex_descriptor>& starts, std::size_t length, std::FILE* f, const walk_options& options = walk_options()) {
+		const walk_engine         w(g, options);
+		thread_pool               pool(options.threads);
+		const std::size_t         batch = std::max<std::size_t>(1, options.batch);
+		vector<vertex_descriptor> buffer(std::min(batch, starts.size()) * length);
+		std::size_t               steps = 0;
+		for (std::size_t lo = 0; lo < starts.size() && length > 0; lo += batch) {
+			const std::size_t hi = std::min(lo + batch, starts.size());
+			const std::size_t taken = w.run(pool, starts, lo, hi, length, &buffer[0]);
+			if (std::fwrite(&buffer[0], sizeof(vertex_descriptor), (hi - lo) * length, f) != (hi - lo) * length)
+				break;
+			steps += taken;}
+		return steps;}
+
+	// --------
+	// pagerank
+	// --------
+
+	/**
+	 * @param g - Adjacency list
+	 * @param ranks - output, ranks[i] is the rank of the ith vertex of vertices(g)
+	 * @param damping - probability of following an edge instead of jumping
+	 * @param tol - stop once the L1 change between two iterations is below tol
+	 * @param max_iter - maximum number of power iterations
+	 * @param threads - number of worker threads, 0 for one per hardware thread
+	 * @return std::size_t
+	 * Computes PageRank by pull-style power iteration over a contiguous in-neighbor
+	 * layout and returns the number of iterations performed. Vertices are split into
+	 * ranges of equal in-degree so every thread pulls about the same number of edges.
+	 * Rank held by vertices without out-edges is spread evenly over all vertices.
+	 */
+	friend std::size_t pagerank (const Graph& g, vector<double>& ranks, double damping = 0.85, double tol = 1e-6, std::size_t max_iter = 100, std::size_t threads = 0) {
+		const csr         in = g.compress(true);
+		const std::size_t n  = in.vertices.size();
+		ranks.assign(n, 1.0 / n);
+		if (n == 0)
+			return 0;
+
+		vector<std::size_t> out_degree(n, 0);
+		for (std::size_t e = 0; e < in.targets.size(); ++e)
+			++out_degree[in.targets[e]];
+
+		thread_pool               pool(threads);
+		const vector<std::size_t> bounds = balanced_ranges(in.offsets, pool.size());
+		vector<double>            next(n);
+		vector<double>            contrib(n);
+		vector<double>            next_contrib(n);
+		vector<double>            residual(pool.size());
+		vector<double>            dangling(pool.size());
+
+		double lost = 0;
+		for (std::size_t v = 0; v < n; ++v) {
+			contrib[v] = out_degree[v] ? ranks[v] / out_degree[v] : 0;
+			if (out_degree[v] == 0)
+				lost += ranks[v];}
+
+		std::size_t iter = 0;
+		while (iter < max_iter) {
+			const double base = (1 - damping) / n + damping * lost / n;
+			pool.run([&] (std::size_t t) {
+				double dead = 0;
+				for (std::size_t v = bounds[t]; v < bounds[t + 1]; ++v) {
+					double sum = 0;
+					for (std::size_t e = in.offsets[v]; e < in.offsets[v + 1]; ++e)
+						sum += contrib[in.targets[e]];
+					next[v] = base + damping * sum;
+					if (out_degree[v])
+						next_contrib[v] = next[v] / out_degree[v];
+					else {
+						next_contrib[v] = 0;
+						dead += next[v];}}
+				dangling[t] = dead;
+				residual[t] = l1_distance(next, ranks, bounds[t], bounds[t + 1]);});
+			++iter;
+			ranks.swap(next);
+			contrib.swap(next_contrib);
+			double delta = 0;
+			lost = 0;
+			for (std::size_t t = 0; t < pool.size(); ++t) {
+				delta += residual[t];
+				lost  += dangling[t];}
+			if (delta < tol)
+				break;}
+		return iter;}
+
+
+	// ------------
+	// set_dag_mode
+	// ------------
+
+	/**
+	 * @param on - true to turn DAG mode on, false to turn it off
+	 * @param g - Adjacency list
+	 * @return bool
+	 * In DAG mode g keeps a topological order of its vertices, and add_edge refuses any
+	 * edge that would close a cycle. The order is repaired after each edge with the
+	 * Pearce-Kelly algorithm, which only visits vertices ordered between the two ends
+	 * of the new edge. Turning DAG mode on sorts g once and adds the endpoints of any
+	 * edge that are not vertices yet. Returns false, leaving DAG mode off, if g already
+	 * has a cycle.
+	 */
+	friend bool set_dag_mode (bool on, Graph& g) {
+		const bool done = g.start_dag(on);
+		if (done)
+			g.wal.record('d', on, 0);
+		return done;}
+
+	// -----------------
+	// topological_order
+	// -----------------
+
+	/**
+	 * @param g - Adjacency list
+	 * @return const vector<vertex_descriptor>&
+	 * Returns the vertices of g in topological order, kept up to date by add_edge in
+	 * DAG mode. Empty if DAG mode is off.
+	 */
+	friend const vector<vertex_descriptor>& topological_order (const Graph& g) {
+		return g.order;}
+
+	// --------
+	// open_log
+	// --------
+
+	/**
+	 * @param path - log file
+	 * @param batch - number of records written and synced together
+	 * @param g - Adjacency list
+	 * @return bool
+	 * Appends every later add_vertex, vertex, add_edge, set_dag_mode and reorder on g
+	 * to the log at path. Records are buffered and committed batch at a time, so up to
+	 * batch - 1 of the latest mutations can be lost in a crash. A log left by an older
+	 * snapshot of g, or shorter than its header, is replaced by an empty one. Returns
+	 * false if the file cannot be opened or is not a log, or if the log of g failed;
+	 * take a snapshot to start a new one.
+	 */
+	friend bool open_log (const std::string& path, std::size_t batch, Graph& g) {
+		return g.wal.open(path, batch, false);}
+
+	/**
+	 * @param g - Adjacency list
+	 * @return bool
+	 * commits the buffered log records of g; returns false if a write or sync of the
+	 * log has failed since it was started, in which case later mutations are not logged
+	 */
+	friend bool flush_log (Graph& g) {
+		return g.wal.flush();}
+
+	/**
+	 * @param g - Adjacency list
+	 * @return bool
+	 * commits the buffered log records of g and stops logging; returns false as flush_log does
+	 */
+	friend bool close_log (Graph& g) {
+		return g.wal.close();}
+
+	// --------
+	// snapshot
+	// --------
+
+	/**
+	 * @param path - snapshot file
+	 * @param g - Adjacency list
+	 * @return bool
+	 * Writes g to path, replacing it atomically, and then empties the log of g, since
+	 * the snapshot holds everything the log recorded; this also restarts a log that
+	 * failed. The snapshot keeps vertices, edges, edge descriptors, the hub degree and
+	 * DAG mode, but not property columns. Returns false if the snapshot or the new log
+	 * cannot be written.
+	 */
+	friend bool snapshot (const std::string& path, Graph& g) {
+		g.wal.flush();
+		const std::string tmp = path + ".tmp";
+		std::FILE*        f   = std::fopen(tmp.c_str(), "wb");
+		if (!f)
+			return false;
+
+		const unsigned long long gen = g.wal.generation + 1;
+		const unsigned long long hub = g.hub_degree;
+		const unsigned long long eid = g.eid;
+		const unsigned long long nv  = g.vertices.size();
+		const char               dag = g.dag;
+		unsigned long long       ne  = 0;
+		for (auto it = g.graph.begin(); it != g.graph.end(); ++it)
+			ne += it->second.size();
+
+		bool ok = std::fwrite("GSNP", 4, 1, f) == 1;
+		ok = ok && write_raw(f, gen) && write_raw(f, g.vid) && write_raw(f, hub) && write_raw(f, dag);
+		ok = ok && write_raw(f, eid) && write_raw(f, nv);
+		for (auto it = g.vertices.begin(); ok && it != g.vertices.end(); ++it)
+			ok = write_raw(f, it->second);
+		ok = ok && write_raw(f, ne);
+		for (auto it = g.graph.begin(); ok && it != g.graph.end(); ++it) {
+			const vector<edges_size_type>& ids = g.edge_ids[it->first];
+			for (std::size_t j = 0; ok && j < it->second.size(); ++j) {
+				const unsigned long long id = ids[j];
+				ok = write_raw(f, it->first) && write_raw(f, it->second[j]) && write_raw(f, id);}}
+		ok = std::fflush(f) == 0 && ok;
+#if defined(__unix__) || defined(__APPLE__)
+		ok = fsync(fileno(f)) == 0 && ok;
+#endif
+		ok = std::fclose(f) == 0 && ok;
+		if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+			std::remove(tmp.c_str());
+			return false;}
+
+		g.wal.generation = gen;
+		return g.wal.reset();}
+
+	// -------
+	// recover
+	// -------
+
+	/**
+	 * @param snapshot_path - snapshot file, may be missing
+	 * @param log_path - log file, may be missing
+	 * @param g - Adjacency list, replaced by the recovered graph
+	 * @return bool
+	 * Loads the snapshot and replays the log records written after it. A log older than
+	 * the snapshot, or shorter than its header, is replaced by an empty log, and a record
+	 * cut short by a crash is dropped from the file. Returns false if either file is
+	 * corrupt or the log continues a newer snapshot than the one loaded, as when the
+	 * snapshot is missing. Logging is off afterwards; call open_log to continue the
+	 * same log.
+	 */
+	friend bool recover (const std::string& snapshot_path, const std::string& log_path, Graph& g) {
+		g.wal.close();
+		g = Graph();
+
+		if (std::FILE* f = std::fopen(snapshot_path.c_str(), "rb")) {
+			const bool ok = g.load_snapshot(f);
+			std::fclose(f);
+			if (!ok)
+				return false;}
+
+		std::FILE* f = std::fopen(log_path.c_str(), "rb");
+		if (!f)
+			return true;
+		vector<char> bytes;
+		char         chunk[4096];
+		for (std::size_t n; (n = std::fread(chunk, 1, sizeof(chunk), f)) > 0; )
+			bytes.insert(bytes.end(), chunk, chunk + n);
+		std::fclose(f);
+
+		const std::size_t head = journal::head;
+		const std::size_t size = 1 + 2 * sizeof(int);
+		unsigned long long gen = 0;
+		if (bytes.size() >= head && std::memcmp(&bytes[0], "GLOG", 4) != 0)
+			return false;
+		if (bytes.size() >= head)
+			std::memcpy(&gen, &bytes[4], sizeof(gen));
+		if (bytes.size() < head || gen < g.wal.generation) {
+			const vector<char> empty = journal::header(g.wal.generation);
+			return journal::replace(log_path, &empty[0], empty.size());}
+		if (gen > g.wal.generation)
+			return false;
+
+		std::size_t at = head;
+		for (; at + size <= bytes.size(); at += size) {
+			int a;
+			int b;
+			std::memcpy(&a, &bytes[at + 1], sizeof(a));
+			std::memcpy(&b, &bytes[at + 1 + sizeof(a)], sizeof(b));
+			switch (bytes[at]) {
+				case 'a': add_vertex(g);                        break;
+				case 'n': vertex(a, g);                         break;
+				case 'e': add_edge(a, b, g);                    break;
+				case 'd': set_dag_mode(a != 0, g);              break;
+				case 'r': reorder(g, (ordering)a);              break;
+				default : return false;}}
+
+		return at == bytes.size() || journal::replace(log_path, &bytes[0], at);}
+
+	// -------------------
+	// add_vertex_property
+	// -------------------
+
+	/**
+	 * @param g - Adjacency list
+	 * @param init - value of the property for every existing and future vertex
+	 * @return property_map<T>
+	 * Adds a vertex property stored as one contiguous column indexed by vertex descriptor.
+	 */
+	template <typename T>
+	friend property_map<T> add_vertex_property (Graph& g, const T& init) {
+		return property_map<T>(g.vertex_columns.add(init));}
+
+	// -----------------
+	// add_edge_property
+	// -----------------
+
+	/**
+	 * @param g - Adjacency list
+	 * @param init - value of the property for every existing and future edge
+	 * @return property_map<T>
+	 * Adds an edge property stored as one contiguous column indexed by edge descriptor.
+	 */
+	template <typename T>
+	friend property_map<T> add_edge_property (Graph& g, const T& init) {
+		return property_map<T>(g.edge_columns.add(init));}
+
+	// ----------
+	// edge_index
+	// ----------
+
+	/**
+	 * @param a - source
+	 * @param b - target
+	 * @param g - Adjacency list
+	 * @return std::pair<edges_size_type, bool>
+	 * Same as edge, but for a -> b only. Edge descriptors are dense indices, numbered
+	 * 0, 1, 2, ... as edges are added and kept through reorder, so they key edge
+	 * property columns directly.
+	 */
+	friend std::pair<edges_size_type, bool> edge_index (vertex_descriptor a, vertex_descriptor b, const Graph& g) {
+		auto r = g.graph.find(a);
+		if (r == g.graph.end())
+			return std::make_pair(0, false);
+		auto at = lower_bound(r->second.begin(), r->second.end(), b);
+		if (at == r->second.end() || *at != b)
+			return std::make_pair(0, false);
+		return std::make_pair(g.edge_ids.at(a)[at - r->second.begin()], true);}
+
+	// --------------
+	// set_hub_degree
+	// --------------
+
+	/**
+	 * @param d - out-degree threshold
+	 * @param g - Adjacency list
+	 * Vertices with at least d out-edges keep a bitmap of their targets next to their
+	 * sorted adjacency list, so edge() and common_neighbors() on them are bit tests.
+	 * A bitmap has one bit per descriptor up to the largest target, so a vertex only
+	 * gets one while that is at most 64 bits per out-edge, twice the size of its list.
+	 * Bitmaps are built or dropped right away to match the new threshold.
+	 */
+	friend void set_hub_degree (vertices_size_type d, Graph& g) {
+		assert(d > 0);
+		g.hub_degree = d;
+		g.rebuild_hubs();}
+
+	// ----------------
+	// common_neighbors
+	// ----------------
+
+	/**
+	 * @param a - vertex descriptor a
+	 * @param b - vertex descriptor b
+	 * @param g - Adjacency list
+	 * @return vertices_size_type
+	 * Returns the number of vertices that are targets of both a and b. Two hubs are
+	 * intersected a word at a time, a hub and a list by bit tests, two lists by a merge.
+	 */
+	friend vertices_size_type common_neighbors (vertex_descriptor a, vertex_descriptor b, const Graph& g) {
+		auto ra = g.graph.find(a);
+		auto rb = g.graph.find(b);
+		if (ra == g.graph.end() || rb == g.graph.end())
+			return 0;
+		auto ha = g.hubs.find(a);
+		auto hb = g.hubs.find(b);
+		vertices_size_type n = 0;
+		if (ha != g.hubs.end() && hb != g.hubs.end()) {
+			const std::size_t words = std::min(ha->second.size(), hb->second.size());
+			for (std::size_t w = 0; w < words; ++w)
+				n += std::bitset<64>(ha->second[w] & hb->second[w]).count();}
+		else if (ha != g.hubs.end() || hb != g.hubs.end()) {
+			const vector<std::uint64_t>&      bits = ha != g.hubs.end() ? ha->second : hb->second;
+			const vector<vertex_descriptor>& row  = ha != g.hubs.end() ? rb->second : ra->second;
+			for (std::size_t j = 0; j < row.size(); ++j)
+				n += test_bit(bits, row[j]);}
+		else {
+			auto i = ra->second.begin();
+			auto j = rb->second.begin();
+			while (i != ra->second.end() && j != rb->second.end()) {
+				if (*i < *j)
+					++i;
+				else if (*j < *i)
+					++j;
+				else {
+					++n;
+					++i;
+					++j;}}}
+		return n;}
+
+	// -------
+	// reorder
+	// -------
+
+	/**
+	 * @param g - Adjacency list
+	 * @param strategy - degree_sort, reverse_cuthill_mckee or breadth_first
+	 * @return vector<vertex_descriptor>
+	 * Relabels the vertices of g as 0 .. num_vertices(g) - 1 so that vertices that
+	 * are visited together are numbered together, and rebuilds the adjacency lists
+	 * and edges to match. degree_sort puts the highest degree vertices first,
+	 * reverse_cuthill_mckee minimizes the bandwidth of the adjacency matrix and
+	 * breadth_first numbers each component in BFS order. Edge direction is ignored
+	 * when choosing the order. Endpoints of edges that were never added as vertices
+	 * are added first. Returns perm where perm[old] is the new descriptor of old,
+	 * or -1 if old was not a vertex. Edge descriptors are kept, so num_edges(g) is
+	 * unchanged and source and target of an old edge descriptor give its new endpoints.
+	 */
+	friend vector<vertex_descriptor> reorder (Graph& g, ordering strategy) {
+		for (auto it = g.graph.begin(); it != g.graph.end(); ++it) {
+			if (it->second.empty())
+				continue; // rows left by lookups such as adjacent_vertices are not edges
+			g.adopt(it->first);
+			for (std::size_t j = 0; j < it->second.size(); ++j)
+				g.adopt(it->second[j]);}
+
+		const csr         out = g.compress(false);
+		const csr         in  = g.compress(true);
+		const std::size_t n   = out.vertices.size();
+
+		vector<std::size_t> degree(n);
+		for (std::size_t v = 0; v < n; ++v)
+			degree[v] = out.offsets[v + 1] - out.offsets[v] + in.offsets[v + 1] - in.offsets[v];
+
+		vector<std::size_t> order; // new dense index -> old dense index
+		order.reserve(n);
+		if (strategy == degree_sort) {
+			for (std::size_t v = 0; v < n; ++v)
+				order.push_back(v);
+			std::stable_sort(order.begin(), order.end(), [&] (std::size_t a, std::size_t b) {
+				return degree[a] > degree[b];});}
+		else {
+			vector<std::size_t> seeds;
+			for (std::size_t v = 0; v < n; ++v)
+				seeds.push_back(v);
+			if (strategy == reverse_cuthill_mckee)
+				std::stable_sort(seeds.begin(), seeds.end(), [&] (std::size_t a, std::size_t b) {
+					return degree[a] < degree[b];});
+
+			vector<bool>        seen(n, false);
+			vector<std::size_t> next;
+			for (std::size_t s = 0; s < n; ++s) {
+				if (seen[seeds[s]])
+					continue;
+				seen[seeds[s]] = true;
+				order.push_back(seeds[s]);
+				for (std::size_t head = order.size() - 1; head < order.size(); ++head) {
+					const std::size_t v = order[head];
+					next.clear();
+					for (std::size_t e = out.offsets[v]; e < out.offsets[v + 1]; ++e)
+						next.push_back(out.targets[e]);
+					for (std::size_t e = in.offsets[v]; e < in.offsets[v + 1]; ++e)
+						next.push_back(in.targets[e]);
+					if (strategy == reverse_cuthill_mckee)
+						std::stable_sort(next.begin(), next.end(), [&] (std::size_t a, std::size_t b) {
+							return degree[a] < degree[b];});
+					else
+						std::sort(next.begin(), next.end());
+					for (std::size_t j = 0; j < next.size(); ++j)
+						if (!seen[next[j]]) {
+							seen[next[j]] = true;
+							order.push_back(next[j]);}}}
+			if (strategy == reverse_cuthill_mckee)
+				std::reverse(order.begin(), order.end());}
+
+		vector<vertex_descriptor> relabel(n); // old dense index -> new descriptor
+		for (std::size_t i = 0; i < n; ++i)
+			relabel[order[i]] = (vertex_descriptor)i;
+
+		vector<vertex_descriptor> perm(n == 0 ? 0 : out.vertices.back() + 1, -1);
+		for (std::size_t v = 0; v < n; ++v)
+			perm[out.vertices[v]] = relabel[v];
+
+		map< vertex_descriptor, vector<vertex_descriptor> > rows;
+		map< vertex_descriptor, vector<edges_size_type> >   ids;
+		for (auto it = g.graph.begin(); it != g.graph.end(); ++it) {
+			if (it->second.empty())
+				continue;
+			const vector<edges_size_type>&                  old = g.edge_ids[it->first];
+			vector< pair<vertex_descriptor, edges_size_type> > row;
+			for (std::size_t j = 0; j < it->second.size(); ++j)
+				row.push_back(make_pair(perm[it->second[j]], old[j]));
+			sort(row.begin(), row.end());
+			const vertex_descriptor a = perm[it->first];
+			for (std::size_t j = 0; j < row.size(); ++j) {
+				rows[a].push_back(row[j].first);
+				ids[a].push_back(row[j].second);}}
+		g.graph.swap(rows);
+		g.edge_ids.swap(ids);
+
+		vector<std::size_t> from(n); // new descriptor -> old descriptor
+		g.vertices.clear();
+		g.listed.resize(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			g.vertices[i] = (vertex_descriptor)i;
+			g.listed[i]   = (vertex_descriptor)i;
+			from[i]       = out.vertices[order[i]];}
+		g.vertex_columns.permute(from);
+
+		for (std::size_t e = 0; e < g.ends.size(); ++e)
+			g.ends[e] = make_pair(perm[g.ends[e].first], perm[g.ends[e].second]);
+		g.vid = (vertex_descriptor)n;
+		g.rebuild_hubs();
+		if (g.dag)
+			g.start_dag(true);
+		g.wal.record('r', strategy, 0);
+		return perm;}
+
+private:
+	// -------------
+	// load_snapshot
+	// -------------
+
+	/**
+	 * @param f - snapshot file written by snapshot
+	 * @return bool
+	 * fills this empty graph from f; returns false if f is corrupt
+	 */
+	bool load_snapshot (std::FILE* f) {
+		char               magic[4];
+		unsigned long long gen;
+		unsigned long long hub;
+		unsigned long long ids;
+		unsigned long long nv;
+		unsigned long long ne;
+		char               on;
+		vertex_descriptor  top;
+		if (std::fread(magic, 4, 1, f) != 1 || std::memcmp(magic, "GSNP", 4) != 0)
+			return false;
+		if (!read_raw(f, gen) || !read_raw(f, top) || !read_raw(f, hub) || !read_raw(f, on) || !read_raw(f, ids) || !read_raw(f, nv))
+			return false;
+		for (unsigned long long i = 0; i < nv; ++i) {
+			vertex_descriptor v;
+			if (!read_raw(f, v))
+				return false;
+			adopt(v);}
+		if (!read_raw(f, ne))
+			return false;
+		for (unsigned long long i = 0; i < ne; ++i) {
+			vertex_descriptor  a;
+			vertex_descriptor  b;
+			unsigned long long id;
+			if (!read_raw(f, a) || !read_raw(f, b) || !read_raw(f, id))
+				return false;
+			graph[a].push_back(b);
+			edge_ids[a].push_back(id);
+			if (ends.size() <= id)
+				ends.resize(id + 1);
+			ends[id] = make_pair(a, b);}
+		wal.generation = gen;
+		hub_degree     = hub;
+		eid            = ids;
+		vid            = top;
+		edge_columns.grow(eid);
+		rebuild_hubs();
+		return !on || start_dag(true);}
+
+	// ---------
+	// write_raw
+	// ---------
+
+	/**
+	 * @param f - file
+	 * @param v - value
+	 * @return bool
+	 * writes the bytes of v to f; returns whether that worked
+	 */
+	template <typename T>
+	static bool write_raw (std::FILE* f, const T& v) {
+		return std::fwrite(&v, sizeof(v), 1, f) == 1;}
+
+	// --------
+	// read_raw
+	// --------
+
+	/**
+	 * @param f - file
+	 * @param v - value, read from f
+	 * @return bool
+	 * reads the bytes of v from f; returns whether that worked
+	 */
+	template <typename T>
+	static bool read_raw (std::FILE* f, T& v) {
+		return std::fread(&v, sizeof(v), 1, f) == 1;}
+
+	// -----
+	// adopt
+	// -----
+
+	/**
+	 * @param v - vertex descriptor
+	 * makes v a vertex if it is not one yet, gives it a slot in every vertex column
+	 * and, in DAG mode, appends it to the order
+	 */
+	void adopt (vertex_descriptor v) {
+		if (vertices.insert(make_pair((vertices_size_type)v, v)).second)
+			listed.insert(upper_bound(listed.begin(), listed.end(), v), v);
+		vertex_columns.grow(v + 1);
+		if (dag && position.insert(make_pair(v, (vertices_size_type)order.size())).second)
+			order.push_back(v);}
+
+	// ---------
+	// start_dag
+	// ---------
+
+	/**
+	 * @param on - whether to turn DAG mode on
+	 * @return bool
+	 * drops the topological order and, if on, builds it again; returns whether DAG
+	 * mode ended up as asked
+	 */
+	bool start_dag (bool on) {
+		dag = false;
+		parents.clear();
+		position.clear();
+		order.clear();
+		if (on)
+			dag = build_order();
+		return dag == on;}
+
+	// -----------
+	// build_order
+	// -----------
+
+	/**
+	 * @return bool
+	 * sorts the graph topologically with Kahn's algorithm, filling parents, position
+	 * and order; returns false, changing nothing, if the graph has a cycle
+	 */
+	bool build_order () {
+		map<vertex_descriptor, vertices_size_type> indegree;
+		for (auto it = vertices.begin(); it != vertices.end(); ++it)
+			indegree[it->second];
+		for (auto it = graph.begin(); it != graph.end(); ++it) {
+			if (!it->second.empty())
+				indegree[it->first];
+			for (std::size_t j = 0; j < it->second.size(); ++j)
+				++indegree[it->second[j]];}
+
+		vector<vertex_descriptor> sorted;
+		for (auto it = indegree.begin(); it != indegree.end(); ++it)
+			if (it->second == 0)
+				sorted.push_back(it->first);
+		for (std::size_t head = 0; head < sorted.size(); ++head) {
+			auto r = graph.find(sorted[head]);
+			if (r == graph.end())
+				continue;
+			for (std::size_t j = 0; j < r->second.size(); ++j)
+				if (--indegree[r->second[j]] == 0)
+					sorted.push_back(r->second[j]);}
+		if (sorted.size() != indegree.size())
+			return false;
+
+		order.swap(sorted);
+		for (std::size_t i = 0; i < order.size(); ++i) {
+			adopt(order[i]);
+			position[order[i]] = i;}
+		for (auto it = graph.begin(); it != graph.end(); ++it)
+			for (std::size_t j = 0; j < it->second.size(); ++j)
+				parents[it->second[j]].push_back(it->first);
+		return true;}
+
+	// ----------
+	// keep_order
+	// ----------
+
+	/**
+	 * @param x - source of a new edge
+	 * @param y - target of a new edge
+	 * @return bool
+	 * Pearce-Kelly: if y comes before x, finds the vertices reachable from y and the
+	 * vertices reaching x within that window of the order and moves the first set
+	 * after the second, reusing their positions. Returns false, changing nothing, if
+	 * x is reachable from y.
+	 */
+	bool keep_order (vertex_descriptor x, vertex_descriptor y) {
+		if (x == y)
+			return false;
+		const vertices_size_type lb = position[y];
+		const vertices_size_type ub = position[x];
+		if (lb > ub)
+			return true;
+
+		set<vertex_descriptor>    seen;
+		vector<vertex_descriptor> forward;
+		vector<vertex_descriptor> stack(1, y);
+		seen.insert(y);
+		while (!stack.empty()) {
+			const vertex_descriptor w = stack.back();
+			stack.pop_back();
+			forward.push_back(w);
+			auto r = graph.find(w);
+			if (r == graph.end())
+				continue;
+			for (std::size_t j = 0; j < r->second.size(); ++j) {
+				const vertex_descriptor c = r->second[j];
+				const vertices_size_type p = position[c];
+				if (p == ub)
+					return false;
+				if (p < ub && seen.insert(c).second)
+					stack.push_back(c);}}
+
+		vector<vertex_descriptor> backward;
+		stack.assign(1, x);
+		seen.insert(x);
+		while (!stack.empty()) {
+			const vertex_descriptor w = stack.back();
+			stack.pop_back();
+			backward.push_back(w);
+			auto r = parents.find(w);
+			if (r == parents.end())
+				continue;
+			for (std::size_t j = 0; j < r->second.size(); ++j) {
+				const vertex_descriptor c = r->second[j];
+				if (position[c] > lb && seen.insert(c).second)
+					stack.push_back(c);}}
+
+		auto before = [&] (vertex_descriptor a, vertex_descriptor b) {
+			return position[a] < position[b];};
+		sort(backward.begin(), backward.end(), before);
+		sort(forward.begin(), forward.end(), before);
+		backward.insert(backward.end(), forward.begin(), forward.end());
+
+		vector<vertices_size_type> slots;
+		for (std::size_t i = 0; i < backward.size(); ++i)
+			slots.push_back(position[backward[i]]);
+		sort(slots.begin(), slots.end());
+		for (std::size_t i = 0; i < backward.size(); ++i) {
+			position[backward[i]] = slots[i];
+			order[slots[i]]       = backward[i];}
+		return true;}
+
+	// --------
+	// has_edge
+	// --------
+
+	/**
+	 * @param a - source
+	 * @param b - target
+	 * @return bool
+	 * returns whether the edge a -> b is in the graph
+	 */
+	bool has_edge (vertex_descriptor a, vertex_descriptor b) const {
+		auto h = hubs.find(a);
+		if (h != hubs.end())
+			return test_bit(h->second, b);
+		auto r = graph.find(a);
+		return r != graph.end() && binary_search(r->second.begin(), r->second.end(), b);}
+
+	// ---------
+	// index_hub
+	// ---------
+
+	/**
+	 * @param a - source of a new edge
+	 * @param b - target of a new edge
+	 * records a -> b in the bitmap of a, giving a a bitmap once it is a hub and
+	 * dropping it once its targets are too sparse for one
+	 */
+	void index_hub (vertex_descriptor a, vertex_descriptor b) {
+		auto                             h   = hubs.find(a);
+		const vector<vertex_descriptor>& row = graph[a];
+		if (!is_hub(row)) {
+			if (h != hubs.end())
+				hubs.erase(h);}
+		else if (h != hubs.end())
+			set_bit(h->second, b);
+		else {
+			vector<std::uint64_t>& bits = hubs[a];
+			for (std::size_t j = 0; j < row.size(); ++j)
+				set_bit(bits, row[j]);}}
+
+	// ------
+	// is_hub
+	// ------
+
+	/**
+	 * @param row - sorted adjacency list
+	 * @return bool
+	 * returns whether row is long enough for a bitmap and dense enough that the bitmap
+	 * takes at most 64 bits per entry
+	 */
+	bool is_hub (const vector<vertex_descriptor>& row) const {
+		return !row.empty() && row.size() >= hub_degree && (std::size_t)row.back() / 64 < row.size();}
+
+	// ------------
+	// rebuild_hubs
+	// ------------
+
+	/**
+	 * rebuilds the bitmap of every vertex whose out-degree is at least hub_degree
+	 */
+	void rebuild_hubs () {
+		hubs.clear();
+		for (auto it = graph.begin(); it != graph.end(); ++it)
+			if (is_hub(it->second)) {
+				vector<std::uint64_t>& bits = hubs[it->first];
+				for (std::size_t j = 0; j < it->second.size(); ++j)
+					set_bit(bits, it->second[j]);}}
+
+	// -------
+	// set_bit
+	// -------
+
+	/**
+	 * @param bits - bitmap, grown as needed
+	 * @param v - vertex descriptor
+	 * sets the bit of v
+	 */
+	static void set_bit (vector<std::uint64_t>& bits, vertex_descriptor v) {
+		assert(v >= 0);
+		if ((std::size_t)v / 64 >= bits.size())
+			bits.resize(v / 64 + 1, 0);
+		bits[v / 64] |= std::uint64_t(1) << (v % 64);}
+
+	// --------
+	// test_bit
+	// --------
+
+	/**
+	 * @param bits - bitmap
+	 * @param v - vertex descriptor
+	 * @return bool
+	 * returns whether the bit of v is set
+	 */
+	static bool test_bit (const vector<std::uint64_t>& bits, vertex_descriptor v) {
+		return v >= 0 && (std::size_t)v / 64 < bits.size() && ((bits[v / 64] >> (v % 64)) & 1);}
+
+	// -----------
+	// walk_engine
+	// -----------
+
+	/**
+	 * Read-only state shared by the threads of random_walks: the CSR snapshot, the
+	 * edge weights in CSR order, and alias tables for the rows of weighted hubs.
+	 * Lighter rows are sampled by scanning their weights.
+	 */
+	struct walk_engine {
+		csr                 out;
+		vector<std::size_t> index;  // vertex descriptor -> dense index
+		vector<double>      weight; // per CSR entry, empty when unweighted
+		vector<double>      total;  // weight of each row
+		vector<char>        hub;    // whether a row has an alias table
+		vector<double>      prob;   // alias table, per CSR entry of hub rows
+		vector<std::size_t> alias;  // alias table, row-local index
+		double              p;
+		double              q;
+		double              top;    // largest node2vec bias
+		unsigned long long  seed;
+
+		walk_engine (const Graph& g, const walk_options& o) : p(o.p), q(o.q), seed(o.seed) {
+			assert(p > 0 && q > 0 && std::isfinite(p) && std::isfinite(q));
+			vector<edges_size_type> ids;
+			out = g.compress(false, &ids);
+			top = std::max(1.0, std::max(1 / p, 1 / q));
+			const std::size_t n = out.vertices.size();
+			index.assign(n == 0 ? 0 : out.vertices.back() + 1, std::size_t(-1));
+			for (std::size_t i = 0; i < n; ++i)
+				index[out.vertices[i]] = i;
+			if (!o.weights)
+				return;
+
+			weight.resize(ids.size());
+			for (std::size_t e = 0; e < ids.size(); ++e)
+				weight[e] = get(*o.weights, ids[e]);
+			total.assign(n, 0);
+			hub.assign(n, 0);
+			prob.resize(ids.size());
+			alias.resize(ids.size());
+			vector<std::size_t> small;
+			vector<std::size_t> large;
+			vector<double>      scaled;
+			for (std::size_t v = 0; v < n; ++v) {
+				const std::size_t b = out.offsets[v];
+				const std::size_t d = out.offsets[v + 1] - b;
+				for (std::size_t i = 0; i < d; ++i)
+					total[v] += weight[b + i];
+				if (d < o.hub_degree || total[v] <= 0)
+					continue;
+
+				// Vose's alias method
+				hub[v] = 1;
+				scaled.resize(d);
+				small.clear();
+				large.clear();
+				for (std::size_t i = 0; i < d; ++i) {
+					scaled[i] = weight[b + i] * d / total[v];
+					(scaled[i] < 1 ? small : large).push_back(i);}
+				while (!small.empty() && !large.empty()) {
+					const std::size_t s = small.back();
+					const std::size_t l = large.back();
+					small.pop_back();
+					prob[b + s]  = scaled[s];
+					alias[b + s] = l;
+					scaled[l]   -= 1 - scaled[s];
+					if (scaled[l] < 1) {
+						large.pop_back();
+						small.push_back(l);}}
+				for (std::size_t i = 0; i < large.size(); ++i)
+					prob[b + large[i]] = 1;
+				for (std::size_t i = 0; i < small.size(); ++i)
+					prob[b + small[i]] = 1;}}
+
+		// splitmix64
+		static unsigned long long next (unsigned long long& s) {
+			unsigned long long z = (s += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			return z ^ (z >> 31);}
+
+		// uniform in [0, 1)
+		static double uniform (unsigned long long& s) {
+			return (next(s) >> 11) * (1.0 / 9007199254740992.0);}
+
+		// a random out-neighbor of v by first-order weight, or npos if there is none
+		std::size_t pick (std::size_t v, unsigned long long& s) const {
+			const std::size_t b = out.offsets[v];
+			const std::size_t d = out.offsets[v + 1] - b;
+			if (d == 0 || (!weight.empty() && total[v] <= 0))
+				return std::size_t(-1);
+			if (weight.empty())
+				return out.targets[b + std::min(d - 1, (std::size_t)(uniform(s) * d))];
+			if (hub[v]) {
+				const std::size_t i = std::min(d - 1, (std::size_t)(uniform(s) * d));
+				return out.targets[b + (uniform(s) < prob[b + i] ? i : alias[b + i])];}
+			double r = uniform(s) * total[v];
+			for (std::size_t i = 0; i + 1 < d; ++i) {
+				r -= weight[b + i];
+				if (r < 0)
+					return out.targets[b + i];}
+			return out.targets[b + d - 1];}
+
+		// the next vertex of a walk at v that came from prev, by rejection sampling
+		std::size_t step (std::size_t prev, std::size_t v, unsigned long long& s) const {
+			while (true) {
+				const std::size_t x = pick(v, s);
+				if (x == std::size_t(-1) || prev == std::size_t(-1) || (p == 1 && q == 1))
+					return x;
+				const double bias = x == prev ? 1 / p :
+					std::binary_search(out.targets.begin() + out.offsets[prev], out.targets.begin() + out.offsets[prev + 1], x) ? 1 : 1 / q;
+				if (uniform(s) * top < bias)
+					return x;}}
+
+		// runs walks lo .. hi - 1 into dst, returns the number of steps taken
+		std::size_t run (thread_pool& pool, const vector<vertex_descriptor>& starts, std::size_t lo, std::size_t hi, std::size_t length, vertex_descriptor* dst) const {
+			const std::size_t        chunk = 256;
+			std::atomic<std::size_t> next_walk(lo);
+			std::atomic<std::size_t> steps(0);
+			pool.run([&] (std::size_t) {
+				std::size_t taken = 0;
+				for (std::size_t c; (c = next_walk.fetch_add(chunk)) < hi; ) {
+					for (std::size_t i = c; i < std::min(c + chunk, hi); ++i) {
+						vertex_descriptor* w    = dst + (i - lo) * length;
+						unsigned long long s    = seed ^ (i * 0xd1342543de82ef95ULL);
+						const vertex_descriptor start = starts[i];
+						std::size_t        v    = start >= 0 && (std::size_t)start < index.size() ? index[start] : std::size_t(-1);
+						std::size_t        prev = std::size_t(-1);
+						std::size_t        k    = 0;
+						if (length > 0)
+							w[k++] = start;
+						for (; k < length && v != std::size_t(-1); ++k) {
+							const std::size_t x = step(prev, v, s);
+							if (x == std::size_t(-1))
+								break;
+							w[k] = out.vertices[x];
+							prev = v;
+							v    = x;
+							++taken;}
+						for (; k < length; ++k)
+							w[k] = -1;}}
+				steps += taken;});
+			return steps;}};
+
+	// --------
+	// compress
+	// --------
+
+	/**
+	 * @param transpose - true to list in-neighbors instead of out-neighbors
+	 * @param ids - if given, filled with the edge descriptor of each entry of targets
+	 * @return csr
+	 * Builds a CSR snapshot of the graph. Edges to vertices that were never added
+	 * are left out. Each row is sorted by dense index.
+	 */
+	csr compress (bool transpose, vector<edges_size_type>* ids = 0) const {
+		const std::size_t npos = std::size_t(-1);
+		csr               c;
+		vector<std::size_t> index;
+		c.vertices.reserve(vertices.size());
+		for (auto it = vertices.begin(); it != vertices.end(); ++it) {
+			assert(it->second >= 0);
+			if ((std::size_t)it->second >= index.size())
+				index.resize(it->second + 1, npos);
+			index[it->second] = c.vertices.size();
+			c.vertices.push_back(it->second);}
+
+		auto dense = [&] (vertex_descriptor vd) -> std::size_t {
+			return vd >= 0 && (std::size_t)vd < index.size() ? index[vd] : npos;};
+
+		const std::size_t n = c.vertices.size();
+		c.offsets.assign(n + 1, 0);
+		for (auto it = graph.begin(); it != graph.end(); ++it) {
+			const std::size_t a = dense(it->first);
+			if (a == npos)
+				continue;
+			for (std::size_t j = 0; j < it->second.size(); ++j) {
+				const std::size_t b = dense(it->second[j]);
+				if (b != npos)
+					++c.offsets[(transpose ? b : a) + 1];}}
+		for (std::size_t i = 0; i < n; ++i)
+			c.offsets[i + 1] += c.offsets[i];
+
+		c.targets.resize(c.offsets[n]);
+		if (ids)
+			ids->resize(c.offsets[n]);
+		vector<std::size_t> fill(c.offsets.begin(), c.offsets.end() - 1);
+		for (auto it = graph.begin(); it != graph.end(); ++it) {
+			const std::size_t a = dense(it->first);
+			if (a == npos)
+				continue;
+			for (std::size_t j = 0; j < it->second.size(); ++j) {
+				const std::size_t b = dense(it->second[j]);
+				if (b == npos)
+					continue;
+				const std::size_t at = transpose ? fill[b]++ : fill[a]++;
+				c.targets[at] = transpose ? a : b;
+				if (ids)
+					(*ids)[at] = edge_ids.find(it->first)->second[j];}}
+		return c;}
+
+	// ---------------
+	// balanced_ranges
+	// ---------------
+
+	/**
+	 * @param offsets - CSR row offsets
+	 * @param parts - number of ranges
+	 * @return vector<std::size_t>
+	 * Splits the rows into parts contiguous ranges [r[i], r[i + 1]) that each hold
+	 * about the same number of edges plus vertices.
+	 */
+	static vector<std::size_t> balanced_ranges (const vector<std::size_t>& offsets, std::size_t parts) {
+		const std::size_t   n     = offsets.size() - 1;
+		const std::size_t   total = offsets[n] + n;
+		vector<std::size_t> r(parts + 1, n);
+		r[0] = 0;
+		for (std::size_t k = 1; k < parts; ++k) {
+			const std::size_t goal = total * k / parts;
+			std::size_t       lo   = r[k - 1];
+			std::size_t       hi   = n;
+			while (lo < hi) {
+				const std::size_t mid = lo + (hi - lo) / 2;
+				if (offsets[mid] + mid < goal)
+					lo = mid + 1;
+				else
+					hi = mid;}
+			r[k] = lo;}
+		return r;}
+
+	// -----------
+	// l1_distance
+	// -----------
+
+	/**
+	 * @param a - first vector
+	 * @param b - second vector
+	 * @param lo - first index
+	 * @param hi - one past the last index
+	 * @return double
+	 * Returns the sum of |a[i] - b[i]| over [lo, hi). Four independent
+	 * accumulators keep the loop free of a serial dependency so it vectorizes.
+	 */
+	static double l1_distance (const vector<double>& a, const vector<double>& b, std::size_t lo, std::size_t hi) {
+		double      s[4] = {0, 0, 0, 0};
+		std::size_t i    = lo;
+		for (; i + 4 <= hi; i += 4) {
+			s[0] += std::fabs(a[i]     - b[i]);
+			s[1] += std::fabs(a[i + 1] - b[i + 1]);
+			s[2] += std::fabs(a[i + 2] - b[i + 2]);
+			s[3] += std::fabs(a[i + 3] - b[i + 3]);}
+		for (; i < hi; ++i)
+			s[0] += std::fabs(a[i] - b[i]);
+		return (s[0] + s[1]) + (s[2] + s[3]);}
+
+public:
+
 	// -----
 	// valid
 	// -----
@@ -840,8 +2823,14 @@ public:
 
 		graph={};
 		vertices={};
-		edges={};
-
+		listed={};
+		ends={};
+		hubs={};
+		edge_ids={};
+
+		eid = 0;
+		hub_degree = 4096;
+		dag = false;
 		vid = 0;
 
 
@@ -857,5 +2846,10 @@ public:
 };
 
 
+#if defined(__cpp_lib_ranges)
+static_assert(std::random_access_iterator<Graph::vertex_iterator>,    "vertex_iterator is random access");
+static_assert(std::random_access_iterator<Graph::adjacency_iterator>, "adjacency_iterator is random access");
+#endif
+
 
 #endif // Graph_h
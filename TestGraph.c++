@@ -45,6 +45,11 @@ To obtain coverage of the test:
 #include "boost/graph/adjacency_list.hpp"  // adjacency_list
 #include "boost/graph/topological_sort.hpp"// topological_sort
 #include <typeinfo> 
+#include <csignal>  // signal, SIGXFSZ
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h> // getrlimit, setrlimit
+#endif
 
 #include "gtest/gtest.h"
 
@@ -2506,3 +2511,1067 @@ TYPED_TEST(TestGraph, iterator_adjacent_vertices_minusminus_3) {
 
 
 
+
+// --------
+// pagerank
+// --------
+
+TEST(TestPageRank, pagerank_1) {
+	Graph g;
+
+	Graph::vertex_descriptor vdA = add_vertex(g);
+	Graph::vertex_descriptor vdB = add_vertex(g);
+	Graph::vertex_descriptor vdC = add_vertex(g);
+
+	add_edge(vdA, vdB, g);
+	add_edge(vdB, vdC, g);
+	add_edge(vdC, vdA, g);
+
+	vector<double> ranks;
+	pagerank(g, ranks, 0.85, 1e-9, 100, 2);
+
+	ASSERT_EQ(3, ranks.size());
+	ASSERT_NEAR(1.0 / 3, ranks[0], 1e-9);
+	ASSERT_NEAR(1.0 / 3, ranks[1], 1e-9);
+	ASSERT_NEAR(1.0 / 3, ranks[2], 1e-9);}
+
+TEST(TestPageRank, pagerank_2) {
+	Graph g;
+
+	Graph::vertex_descriptor hub = add_vertex(g);
+	for (int i = 0; i < 10; ++i)
+		add_edge(add_vertex(g), hub, g);
+
+	vector<double> ranks;
+	std::size_t iter = pagerank(g, ranks, 0.85, 1e-10, 200, 3);
+
+	ASSERT_LT(iter, 200);
+	double sum = 0;
+	for (std::size_t i = 0; i < ranks.size(); ++i)
+		sum += ranks[i];
+	ASSERT_NEAR(1.0, sum, 1e-9);
+	for (std::size_t i = 1; i < ranks.size(); ++i) {
+		ASSERT_GT(ranks[hub], ranks[i]);
+		ASSERT_NEAR(ranks[1], ranks[i], 1e-12);}}
+
+TEST(TestPageRank, pagerank_3) {
+	Graph g;
+
+	for (int i = 0; i < 50; ++i)
+		add_vertex(g);
+	for (int i = 0; i < 50; ++i) {
+		add_edge(i, (i * 7 + 3) % 50, g);
+		add_edge(i, (i * 13 + 1) % 50, g);
+		if (i % 5 == 0)
+			add_edge(i, 0, g);}
+
+	vector<double> serial;
+	vector<double> parallel;
+	std::size_t iter1 = pagerank(g, serial,   0.85, 1e-12, 500, 1);
+	std::size_t iter4 = pagerank(g, parallel, 0.85, 1e-12, 500, 4);
+
+	ASSERT_EQ(iter1, iter4);
+	ASSERT_EQ(serial.size(), parallel.size());
+	for (std::size_t i = 0; i < serial.size(); ++i)
+		ASSERT_NEAR(serial[i], parallel[i], 1e-12);}
+
+// -------
+// reorder
+// -------
+
+TEST(TestReorder, reorder_1) {
+	Graph g;
+
+	for (int i = 0; i < 5; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	add_edge(1, 3, g);
+	add_edge(2, 3, g);
+	add_edge(4, 3, g);
+	add_edge(3, 0, g);
+
+	vector<Graph::vertex_descriptor> perm = reorder(g, Graph::degree_sort);
+
+	ASSERT_EQ(5, perm.size());
+	ASSERT_EQ(0, perm[3]);
+	ASSERT_EQ(5, num_vertices(g));
+	ASSERT_EQ(5, num_edges(g));
+	ASSERT_TRUE(edge(perm[0], perm[1], g).second);
+	ASSERT_TRUE(edge(perm[1], perm[3], g).second);
+	ASSERT_TRUE(edge(perm[2], perm[3], g).second);
+	ASSERT_TRUE(edge(perm[4], perm[3], g).second);
+	ASSERT_EQ(perm[0], target(edge(perm[3], perm[0], g).first, g));}
+
+TEST(TestReorder, reorder_2) {
+	Graph g;
+
+	// a path 0 - 5 - 2 - 7 - 1 - 4 - 6 - 3 with scattered labels
+	const int path[] = {0, 5, 2, 7, 1, 4, 6, 3};
+	for (int i = 0; i < 8; ++i)
+		add_vertex(g);
+	for (int i = 0; i + 1 < 8; ++i)
+		add_edge(path[i], path[i + 1], g);
+
+	vector<Graph::vertex_descriptor> perm = reorder(g, Graph::reverse_cuthill_mckee);
+
+	ASSERT_EQ(7, num_edges(g));
+	for (int i = 0; i + 1 < 8; ++i)
+		ASSERT_EQ(1, std::abs(perm[path[i]] - perm[path[i + 1]]));}
+
+TEST(TestReorder, reorder_3) {
+	Graph g;
+
+	for (int i = 0; i < 6; ++i)
+		add_vertex(g);
+	add_edge(0, 5, g);
+	add_edge(0, 4, g);
+	add_edge(5, 1, g);
+	add_edge(2, 3, g);
+
+	vector<Graph::vertex_descriptor> perm = reorder(g, Graph::breadth_first);
+
+	ASSERT_EQ(0, perm[0]);
+	ASSERT_EQ(1, perm[4]);
+	ASSERT_EQ(2, perm[5]);
+	ASSERT_EQ(3, perm[1]);
+	ASSERT_EQ(4, perm[2]);
+	ASSERT_EQ(5, perm[3]);
+
+	std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> p = adjacent_vertices(0, g);
+	ASSERT_EQ(1, *p.first);
+	++p.first;
+	ASSERT_EQ(2, *p.first);
+	ASSERT_EQ(6, add_vertex(g));}
+
+TEST(TestReorder, reorder_4) {
+	Graph g;
+
+	// (0, 12) and (1, 2) would collide if edges were keyed by 10 * a + b
+	for (int i = 0; i < 30; ++i)
+		add_vertex(g);
+	vector<Graph::edge_descriptor> ed;
+	for (int i = 0; i < 30; ++i)
+		for (int j = 0; j < 30; j += 1 + (i * j) % 7)
+			if (i != j)
+				ed.push_back(add_edge(i, j, g).first);
+	vector<Graph::vertex_descriptor> a;
+	vector<Graph::vertex_descriptor> b;
+	for (std::size_t e = 0; e < ed.size(); ++e) {
+		a.push_back(source(ed[e], g));
+		b.push_back(target(ed[e], g));}
+	const Graph::edges_size_type n = num_edges(g);
+	ASSERT_EQ(ed.size(), n);
+
+	vector<Graph::vertex_descriptor> perm = reorder(g, Graph::degree_sort);
+
+	ASSERT_EQ(n, num_edges(g));
+	for (std::size_t e = 0; e < ed.size(); ++e) {
+		ASSERT_EQ(perm[a[e]], source(ed[e], g));
+		ASSERT_EQ(perm[b[e]], target(ed[e], g));
+		ASSERT_EQ(ed[e], edge(perm[a[e]], perm[b[e]], g).first);}}
+
+// ---
+// hub
+// ---
+
+TEST(TestHub, hub_1) {
+	Graph g;
+	set_hub_degree(4, g);
+
+	for (int i = 0; i < 200; ++i)
+		add_vertex(g);
+	for (int i = 1; i < 200; i += 2)
+		add_edge(0, i, g);
+	add_edge(150, 7, g);
+
+	ASSERT_TRUE(edge(0, 99, g).second);
+	ASSERT_FALSE(edge(0, 98, g).second);
+	ASSERT_FALSE(edge(0, 500, g).second);
+	ASSERT_TRUE(edge(99, 0, g).second);
+	ASSERT_EQ(99, target(edge(0, 99, g).first, g));
+	ASSERT_FALSE(add_edge(0, 99, g).second);
+	ASSERT_TRUE(add_edge(0, 98, g).second);
+	ASSERT_TRUE(edge(0, 98, g).second);
+	ASSERT_TRUE(edge(150, 7, g).second);
+	ASSERT_FALSE(edge(150, 8, g).second);
+	ASSERT_EQ(102, num_edges(g));}
+
+TEST(TestHub, hub_2) {
+	Graph g;
+	set_hub_degree(3, g);
+
+	for (int i = 0; i < 100; ++i)
+		add_vertex(g);
+	for (int i = 10; i < 100; i += 2)
+		add_edge(0, i, g);
+	for (int i = 10; i < 100; i += 3)
+		add_edge(1, i, g);
+	add_edge(2, 16, g);
+	add_edge(2, 22, g);
+	add_edge(3, 16, g);
+	add_edge(3, 17, g);
+
+	ASSERT_EQ(15, common_neighbors(0, 1, g));
+	ASSERT_EQ(2,  common_neighbors(0, 2, g));
+	ASSERT_EQ(2,  common_neighbors(2, 1, g));
+	ASSERT_EQ(1,  common_neighbors(2, 3, g));
+	ASSERT_EQ(0,  common_neighbors(2, 50, g));}
+
+TEST(TestHub, hub_3) {
+	Graph g;
+
+	for (int i = 0; i < 40; ++i)
+		add_vertex(g);
+	for (int i = 1; i < 40; ++i)
+		add_edge(0, i, g);
+	add_edge(1, 2, g);
+
+	ASSERT_EQ(39, common_neighbors(0, 0, g));
+	set_hub_degree(8, g);
+	ASSERT_EQ(39, common_neighbors(0, 0, g));
+	ASSERT_TRUE(edge(0, 39, g).second);
+
+	vector<Graph::vertex_descriptor> perm = reorder(g, Graph::breadth_first);
+	ASSERT_TRUE(edge(perm[0], perm[39], g).second);
+	ASSERT_TRUE(edge(perm[1], perm[2], g).second);
+	ASSERT_FALSE(edge(perm[2], perm[3], g).second);
+
+	set_hub_degree(100, g);
+	ASSERT_TRUE(edge(perm[0], perm[39], g).second);
+	ASSERT_EQ(1, common_neighbors(perm[0], perm[1], g));}
+
+TEST(TestHub, hub_4) {
+	Graph g;
+	set_hub_degree(4, g);
+
+	for (int i = 0; i < 10; ++i)
+		add_vertex(g);
+	for (int i = 1; i < 10; ++i)
+		add_edge(0, i, g);
+
+	ASSERT_FALSE(add_edge(0, -1, g).second);
+	ASSERT_FALSE(add_edge(-1, 0, g).second);
+	ASSERT_FALSE(edge(0, -1, g).second);
+	ASSERT_EQ(9, num_edges(g));
+	ASSERT_EQ(10, num_vertices(g));}
+
+TEST(TestHub, hub_5) {
+	Graph g;
+	set_hub_degree(4, g);
+
+	// a far target makes the bitmap of 0 too sparse to keep
+	for (int i = 1; i < 10; ++i) {
+		add_edge(0, i, g);
+		add_edge(20, i, g);}
+	add_edge(0, 1 << 30, g);
+	ASSERT_TRUE(edge(0, 1 << 30, g).second);
+	ASSERT_TRUE(edge(0, 5, g).second);
+	ASSERT_FALSE(edge(0, 10, g).second);
+	ASSERT_EQ(9, common_neighbors(0, 20, g));
+	ASSERT_EQ(18, edge(0, 1 << 30, g).first);
+
+	set_hub_degree(2, g);
+	ASSERT_TRUE(edge(20, 9, g).second);
+	ASSERT_FALSE(edge(20, 1 << 30, g).second);
+	ASSERT_EQ(9, common_neighbors(20, 0, g));}
+
+// ---
+// dag
+// ---
+
+TEST(TestDag, dag_1) {
+	Graph g;
+	ASSERT_TRUE(set_dag_mode(true, g));
+
+	for (int i = 0; i < 5; ++i)
+		add_vertex(g);
+	ASSERT_TRUE(add_edge(3, 4, g).second);
+	ASSERT_TRUE(add_edge(2, 3, g).second);
+	ASSERT_TRUE(add_edge(1, 2, g).second);
+	ASSERT_TRUE(add_edge(0, 1, g).second);
+
+	const vector<Graph::vertex_descriptor>& order = topological_order(g);
+	ASSERT_EQ(5, order.size());
+	for (int i = 0; i < 5; ++i)
+		ASSERT_EQ(i, order[i]);}
+
+TEST(TestDag, dag_2) {
+	Graph g;
+	set_dag_mode(true, g);
+
+	for (int i = 0; i < 4; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	add_edge(1, 2, g);
+	add_edge(2, 3, g);
+
+	ASSERT_FALSE(add_edge(3, 0, g).second);
+	ASSERT_FALSE(add_edge(2, 1, g).second);
+	ASSERT_FALSE(add_edge(2, 2, g).second);
+	ASSERT_FALSE(edge(3, 0, g).second);
+	ASSERT_EQ(3, num_edges(g));
+	ASSERT_TRUE(add_edge(0, 3, g).second);
+
+	ASSERT_TRUE(set_dag_mode(false, g));
+	ASSERT_TRUE(topological_order(g).empty());
+	ASSERT_TRUE(add_edge(3, 0, g).second);
+	ASSERT_FALSE(set_dag_mode(true, g));
+	ASSERT_TRUE(topological_order(g).empty());}
+
+TEST(TestDag, dag_3) {
+	Graph g;
+
+	for (int i = 0; i < 30; ++i)
+		add_vertex(g);
+	add_edge(5, 2, g);
+	ASSERT_TRUE(set_dag_mode(true, g));
+
+	unsigned long long state = 7;
+	for (int k = 0; k < 400; ++k) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		const int a = (state >> 33) % 30;
+		const int b = (state >> 17) % 30;
+
+		// b reaches a <=> a -> b closes a cycle
+		vector<bool> reach(30, false);
+		vector<int>  stack(1, b);
+		reach[b] = true;
+		while (!stack.empty()) {
+			const int w = stack.back();
+			stack.pop_back();
+			std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> p = adjacent_vertices(w, g);
+			for (; p.first != p.second; ++p.first)
+				if (!reach[*p.first]) {
+					reach[*p.first] = true;
+					stack.push_back(*p.first);}}
+
+		bool existed = false;
+		std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> q = adjacent_vertices(a, g);
+		for (; q.first != q.second; ++q.first)
+			existed = existed || *q.first == b;
+		ASSERT_EQ(!reach[a] && !existed, add_edge(a, b, g).second);}
+
+	const vector<Graph::vertex_descriptor>& order = topological_order(g);
+	ASSERT_EQ(30, order.size());
+	vector<int> at(30);
+	for (int i = 0; i < 30; ++i)
+		at[order[i]] = i;
+	for (int a = 0; a < 30; ++a) {
+		std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> p = adjacent_vertices(a, g);
+		for (; p.first != p.second; ++p.first)
+			ASSERT_LT(at[a], at[*p.first]);}
+
+	ASSERT_EQ(30, add_vertex(g));
+	ASSERT_EQ(30, topological_order(g).back());}
+
+TEST(TestDag, dag_4) {
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");
+
+	Graph g;
+	ASSERT_TRUE(open_log("TestGraph.wal", 1, g));
+	add_vertex(g);
+	ASSERT_TRUE(set_dag_mode(true, g));
+	ASSERT_FALSE(add_edge(5, 5, g).second);
+	ASSERT_EQ(1, num_vertices(g));
+	ASSERT_EQ(1, topological_order(g).size());
+	ASSERT_TRUE(add_edge(0, 3, g).second);
+	close_log(g);
+
+	Graph h;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", h));
+	ASSERT_EQ(2, num_vertices(h));
+	ASSERT_EQ(topological_order(g), topological_order(h));
+
+	std::remove("TestGraph.wal");}
+
+// --------
+// property
+// --------
+
+TEST(TestProperty, property_1) {
+	Graph g;
+
+	Graph::vertex_descriptor vdA = add_vertex(g);
+	Graph::property_map<double> score = add_vertex_property(g, 0.5);
+	Graph::property_map<int>    label = add_vertex_property(g, -1);
+	Graph::vertex_descriptor vdB = add_vertex(g);
+	Graph::vertex_descriptor vdC = vertex(7, g);
+
+	ASSERT_EQ(8, score.values().size());
+	ASSERT_EQ(0.5, get(score, vdA));
+	ASSERT_EQ(0.5, get(score, vdC));
+	put(score, vdB, 2.0);
+	label[vdC] = 3;
+	ASSERT_EQ(2.0, get(score, vdB));
+	ASSERT_EQ(3,   get(label, vdC));
+	ASSERT_EQ(-1,  get(label, vdA));}
+
+TEST(TestProperty, property_2) {
+	Graph g;
+
+	for (int i = 0; i < 4; ++i)
+		add_vertex(g);
+	add_edge(0, 3, g);
+	Graph::property_map<long> stamp = add_edge_property(g, 0L);
+	add_edge(0, 1, g);
+	add_edge(2, 1, g);
+
+	ASSERT_EQ(0, edge_index(0, 3, g).first);
+	ASSERT_EQ(1, edge_index(0, 1, g).first);
+	ASSERT_EQ(2, edge_index(2, 1, g).first);
+	ASSERT_FALSE(edge_index(1, 2, g).second);
+	ASSERT_FALSE(edge_index(3, 0, g).second);
+	ASSERT_EQ(3, stamp.values().size());
+	ASSERT_EQ(2, edge(2, 1, g).first);
+	ASSERT_EQ(2, edge(1, 2, g).first);
+	ASSERT_EQ(2, source(edge(2, 1, g).first, g));
+
+	put(stamp, edge_index(0, 1, g).first, 100L);
+	put(stamp, edge_index(2, 1, g).first, 200L);
+	long sum = 0;
+	for (std::size_t i = 0; i < stamp.values().size(); ++i)
+		sum += stamp.values()[i];
+	ASSERT_EQ(300, sum);}
+
+TEST(TestProperty, property_3) {
+	Graph g;
+
+	for (int i = 0; i < 4; ++i)
+		add_vertex(g);
+	add_edge(3, 0, g);
+	add_edge(3, 1, g);
+	add_edge(3, 2, g);
+	Graph::property_map<int>  name   = add_vertex_property(g, 0);
+	Graph::property_map<char> weight = add_edge_property(g, 'x');
+	for (int i = 0; i < 4; ++i)
+		put(name, i, 10 * i);
+	put(weight, edge_index(3, 2, g).first, 'w');
+
+	Graph h = g;
+	put(name, 0, -5);
+	vector<Graph::vertex_descriptor> perm = reorder(g, Graph::degree_sort);
+
+	ASSERT_EQ(0, perm[3]);
+	for (int i = 1; i < 4; ++i)
+		ASSERT_EQ(10 * i, get(name, perm[i]));
+	ASSERT_EQ(-5, get(name, perm[0]));
+	ASSERT_EQ('w', get(weight, edge_index(perm[3], perm[2], g).first));
+	ASSERT_EQ('x', get(weight, edge_index(perm[3], perm[1], g).first));
+	ASSERT_TRUE(edge_index(3, 0, h).second);
+	ASSERT_FALSE(edge_index(perm[3], perm[0], h).second);}
+
+TEST(TestProperty, property_4) {
+	Graph g;
+
+	add_vertex(g);
+	Graph::property_map<int> label = add_vertex_property(g, 7);
+	add_edge(0, 5, g);
+	add_edge(12, 3, g);
+
+	ASSERT_EQ(13, label.values().size());
+	put(label, 12, 1);
+	ASSERT_EQ(1, get(label, 12));
+	ASSERT_EQ(7, get(label, 5));}
+
+// --------------
+// random access
+// --------------
+
+TEST(TestRandomAccess, random_access_1) {
+	typedef Graph::vertex_iterator vertex_iterator;
+	ASSERT_TRUE((std::is_same<std::iterator_traits<vertex_iterator>::iterator_category, std::random_access_iterator_tag>::value));
+
+	Graph g;
+	for (int i = 0; i < 10; ++i)
+		add_vertex(g);
+
+	std::pair<vertex_iterator, vertex_iterator> p = vertices(g);
+	ASSERT_EQ(10, std::distance(p.first, p.second));
+	ASSERT_EQ(10, p.second - p.first);
+	ASSERT_EQ(4, p.first[4]);
+	ASSERT_EQ(7, *(p.first + 7));
+	ASSERT_EQ(7, *(7 + p.first));
+	ASSERT_EQ(9, *(p.second - 1));
+	ASSERT_TRUE(p.first < p.second);
+	ASSERT_TRUE(p.first + 10 == p.second);
+	ASSERT_TRUE(p.second >= p.first + 10);
+	ASSERT_FALSE(p.first > p.first);
+	ASSERT_EQ(10, num_vertices(g));}
+
+TEST(TestRandomAccess, random_access_2) {
+	typedef Graph::adjacency_iterator adjacency_iterator;
+	ASSERT_TRUE((std::is_same<std::iterator_traits<adjacency_iterator>::iterator_category, std::random_access_iterator_tag>::value));
+
+	Graph g;
+	for (int i = 0; i < 100; ++i)
+		add_vertex(g);
+	for (int i = 99; i > 0; i -= 3)
+		add_edge(0, i, g);
+
+	std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(0, g);
+	ASSERT_EQ(33, p.second - p.first);
+	ASSERT_EQ(3, p.first[0]);
+	ASSERT_EQ(99, p.first[32]);
+	ASSERT_TRUE(std::binary_search(p.first, p.second, 42));
+	ASSERT_FALSE(std::binary_search(p.first, p.second, 43));
+	ASSERT_EQ(13, std::lower_bound(p.first, p.second, 40) - p.first);
+	ASSERT_EQ(99, *std::max_element(p.first, p.second));}
+
+TEST(TestRandomAccess, random_access_3) {
+	Graph g;
+	for (int i = 0; i < 6; ++i)
+		add_vertex(g);
+	add_edge(1, 2, g);
+
+	std::pair<Graph::vertex_iterator, Graph::vertex_iterator> p = vertices(g);
+	vector<int> seen(6, 0);
+	std::for_each(p.first, p.second, [&] (Graph::vertex_descriptor v) {++seen[v];});
+	ASSERT_EQ(6, std::count(seen.begin(), seen.end(), 1));
+	ASSERT_EQ(6, num_vertices(g));
+
+	std::reverse_iterator<Graph::vertex_iterator> r(p.second);
+	ASSERT_EQ(5, *r);
+
+	std::pair<Graph::edge_iterator, Graph::edge_iterator> q = edges(g);
+	ASSERT_TRUE(q.first != q.second);
+	++q.first;
+	ASSERT_TRUE(q.first == q.second);}
+
+TEST(TestRandomAccess, random_access_4) {
+	Graph g;
+	add_vertex(g);
+	vertex(9, g);
+	set_dag_mode(true, g);
+	add_edge(0, 7, g);
+	add_edge(7, 4, g);
+
+	std::pair<Graph::vertex_iterator, Graph::vertex_iterator> p = vertices(g);
+	ASSERT_EQ(4, p.second - p.first);
+	vector<Graph::vertex_descriptor> seen(p.first, p.second);
+	const Graph::vertex_descriptor expected[] = {0, 4, 7, 9};
+	ASSERT_TRUE(std::equal(seen.begin(), seen.end(), expected));
+	ASSERT_EQ(7, p.first[2]);
+	ASSERT_EQ(9, *(p.second - 1));}
+
+// ---
+// log
+// ---
+
+TEST(TestLog, log_1) {
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");
+
+	Graph g;
+	ASSERT_TRUE(open_log("TestGraph.wal", 4, g));
+	for (int i = 0; i < 5; ++i)
+		add_vertex(g);
+	vertex(9, g);
+	add_edge(0, 1, g);
+	add_edge(1, 4, g);
+	add_edge(9, 2, g);
+	add_edge(0, 1, g);
+	close_log(g);
+
+	Graph h;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", h));
+	ASSERT_EQ(6, num_vertices(h));
+	ASSERT_EQ(3, num_edges(h));
+	ASSERT_TRUE(edge(9, 2, h).second);
+	ASSERT_EQ(2, edge_index(9, 2, h).first);
+	ASSERT_EQ(5, add_vertex(h));
+
+	std::remove("TestGraph.wal");}
+
+TEST(TestLog, log_2) {
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");
+
+	Graph g;
+	open_log("TestGraph.wal", 1, g);
+	for (int i = 0; i < 4; ++i)
+		add_vertex(g);
+	add_edge(3, 2, g);
+	add_edge(2, 1, g);
+	set_dag_mode(true, g);
+	ASSERT_TRUE(snapshot("TestGraph.snapshot", g));
+	add_edge(1, 0, g);
+	ASSERT_FALSE(add_edge(0, 3, g).second);
+	vector<Graph::vertex_descriptor> perm = reorder(g, Graph::breadth_first);
+	add_vertex(g);
+
+	std::FILE* f = std::fopen("TestGraph.wal", "rb");
+	std::fseek(f, 0, SEEK_END);
+	ASSERT_EQ(12 + 3 * 9, std::ftell(f));
+	std::fclose(f);
+
+	Graph h;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", h));
+	ASSERT_EQ(5, num_vertices(h));
+	ASSERT_EQ(3, num_edges(h));
+	ASSERT_EQ(topological_order(g), topological_order(h));
+	for (int a = 0; a < 5; ++a)
+		for (int b = 0; b < 5; ++b)
+			ASSERT_EQ(edge_index(a, b, g), edge_index(a, b, h));
+	ASSERT_FALSE(add_edge(perm[0], perm[3], h).second);
+	ASSERT_TRUE(add_edge(perm[3], perm[0], h).second);
+
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");}
+
+TEST(TestLog, log_3) {
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");
+
+	Graph g;
+	open_log("TestGraph.wal", 100, g);
+	add_vertex(g);
+	add_vertex(g);
+	ASSERT_TRUE(snapshot("TestGraph.snapshot", g));
+	add_edge(0, 1, g);
+	close_log(g);
+
+	// a torn record at the end of the log
+	std::FILE* f = std::fopen("TestGraph.wal", "ab");
+	std::fwrite("e\1\0", 3, 1, f);
+	std::fclose(f);
+
+	Graph h;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", h));
+	ASSERT_EQ(2, num_vertices(h));
+	ASSERT_EQ(1, num_edges(h));
+	f = std::fopen("TestGraph.wal", "rb");
+	std::fseek(f, 0, SEEK_END);
+	ASSERT_EQ(12 + 9, std::ftell(f));
+	std::fclose(f);
+
+	// a log older than the snapshot is not replayed
+	ASSERT_TRUE(snapshot("TestGraph.snapshot", h));
+	Graph k;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", k));
+	ASSERT_EQ(2, num_vertices(k));
+	ASSERT_EQ(1, num_edges(k));
+	f = std::fopen("TestGraph.wal", "rb");
+	std::fseek(f, 0, SEEK_END);
+	ASSERT_EQ(12, std::ftell(f));
+	std::fclose(f);
+
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");}
+
+TEST(TestLog, log_4) {
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");
+
+	// a log cut inside its header counts as empty
+	std::FILE* f = std::fopen("TestGraph.wal", "wb");
+	std::fwrite("GLO", 3, 1, f);
+	std::fclose(f);
+	Graph g;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", g));
+	ASSERT_EQ(0, num_vertices(g));
+
+	// a snapshot taken with the log closed leaves a stale log that open_log restarts
+	ASSERT_TRUE(open_log("TestGraph.wal", 1, g));
+	add_vertex(g);
+	close_log(g);
+	ASSERT_TRUE(snapshot("TestGraph.snapshot", g));
+	ASSERT_TRUE(open_log("TestGraph.wal", 1, g));
+	add_vertex(g);
+	add_edge(0, 1, g);
+	close_log(g);
+
+	Graph h;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", h));
+	ASSERT_EQ(2, num_vertices(h));
+	ASSERT_EQ(1, num_edges(h));
+
+	// a log that continues a missing snapshot cannot be replayed
+	std::remove("TestGraph.snapshot");
+	Graph k;
+	ASSERT_FALSE(recover("TestGraph.snapshot", "TestGraph.wal", k));
+
+	std::remove("TestGraph.wal");}
+
+TEST(TestLog, log_5) {
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");
+
+	// looking at a non-vertex is not logged, so it must not make one
+	Graph g;
+	ASSERT_TRUE(open_log("TestGraph.wal", 1, g));
+	for (int i = 0; i < 3; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	adjacent_vertices(7, g);
+	reorder(g, Graph::degree_sort);
+	adjacent_vertices(8, g);
+	set_dag_mode(true, g);
+	add_edge(2, 0, g);
+	close_log(g);
+	ASSERT_EQ(3, num_vertices(g));
+	ASSERT_EQ(3, topological_order(g).size());
+
+	Graph h;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", h));
+	ASSERT_EQ(num_vertices(g), num_vertices(h));
+	ASSERT_EQ(num_edges(g), num_edges(h));
+	ASSERT_EQ(topological_order(g), topological_order(h));
+
+	std::remove("TestGraph.wal");}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST(TestLog, log_6) {
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");
+
+	Graph g;
+	ASSERT_TRUE(open_log("TestGraph.wal", 1, g));
+
+	// the file may hold the header and two records, so the third write fails
+	rlimit old;
+	getrlimit(RLIMIT_FSIZE, &old);
+	rlimit small = old;
+	small.rlim_cur = 12 + 2 * 9;
+	void (*handler) (int) = std::signal(SIGXFSZ, SIG_IGN);
+	setrlimit(RLIMIT_FSIZE, &small);
+	for (int i = 0; i < 4; ++i)
+		add_vertex(g);
+	const bool flushed = flush_log(g);
+	setrlimit(RLIMIT_FSIZE, &old);
+	std::signal(SIGXFSZ, handler);
+
+	ASSERT_FALSE(flushed);
+	ASSERT_FALSE(close_log(g));
+	ASSERT_FALSE(open_log("TestGraph.wal", 1, g));
+
+	// a snapshot holds the lost mutations and lets the log start over
+	ASSERT_TRUE(snapshot("TestGraph.snapshot", g));
+	ASSERT_TRUE(open_log("TestGraph.wal", 1, g));
+	add_vertex(g);
+	ASSERT_TRUE(close_log(g));
+
+	Graph h;
+	ASSERT_TRUE(recover("TestGraph.snapshot", "TestGraph.wal", h));
+	ASSERT_EQ(5, num_vertices(h));
+
+	std::remove("TestGraph.snapshot");
+	std::remove("TestGraph.wal");}
+#endif
+
+// -----
+// batch
+// -----
+
+TEST(TestBatch, neighborhoods_1) {
+	Graph g;
+
+	for (int i = 0; i < 5; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	add_edge(1, 2, g);
+	add_edge(2, 3, g);
+	add_edge(2, 0, g);
+	add_edge(4, 0, g);
+
+	vector<Graph::vertex_descriptor> sources;
+	sources.push_back(0);
+	sources.push_back(3);
+	sources.push_back(0);
+	vector<Graph::csr> r = neighborhoods(g, sources, 2, 2);
+
+	ASSERT_EQ(3, r.size());
+	ASSERT_EQ(3, r[0].vertices.size());
+	ASSERT_EQ(0, r[0].vertices[0]);
+	ASSERT_EQ(1, r[0].vertices[1]);
+	ASSERT_EQ(2, r[0].vertices[2]);
+	ASSERT_EQ(4, r[0].offsets.size());
+	ASSERT_EQ(3, r[0].targets.size());
+	ASSERT_EQ(1, r[0].targets[r[0].offsets[0]]);
+	ASSERT_EQ(2, r[0].targets[r[0].offsets[1]]);
+	ASSERT_EQ(0, r[0].targets[r[0].offsets[2]]);
+
+	ASSERT_EQ(1, r[1].vertices.size());
+	ASSERT_EQ(0, r[1].targets.size());
+	ASSERT_EQ(r[0].vertices, r[2].vertices);
+	ASSERT_EQ(r[0].targets,  r[2].targets);}
+
+TEST(TestBatch, neighborhoods_2) {
+	Graph g;
+
+	for (int i = 0; i < 60; ++i)
+		add_vertex(g);
+	for (int i = 0; i < 60; ++i) {
+		add_edge(i, (i * 7 + 1) % 60, g);
+		add_edge(i, (i * 11 + 5) % 60, g);}
+
+	vector<Graph::vertex_descriptor> sources;
+	for (int i = 0; i < 60; ++i)
+		sources.push_back(i);
+	vector<Graph::csr> one  = neighborhoods(g, sources, 3, 1);
+	vector<Graph::csr> four = neighborhoods(g, sources, 3, 4);
+
+	for (int i = 0; i < 60; ++i) {
+		ASSERT_EQ(one[i].vertices, four[i].vertices);
+		ASSERT_EQ(one[i].offsets,  four[i].offsets);
+		ASSERT_EQ(one[i].targets,  four[i].targets);
+
+		vector<int> hops(60, -1);
+		vector<int> queue(1, i);
+		hops[i] = 0;
+		for (std::size_t h = 0; h < queue.size(); ++h)
+			if (hops[queue[h]] < 3) {
+				std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> p = adjacent_vertices(queue[h], g);
+				for (; p.first != p.second; ++p.first)
+					if (hops[*p.first] < 0) {
+						hops[*p.first] = hops[queue[h]] + 1;
+						queue.push_back(*p.first);}}
+		ASSERT_EQ(queue.size(), one[i].vertices.size());
+		for (std::size_t j = 0; j < one[i].vertices.size(); ++j)
+			ASSERT_LE(0, hops[one[i].vertices[j]]);}}
+
+TEST(TestBatch, induced_subgraphs_1) {
+	Graph g;
+
+	for (int i = 0; i < 6; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	add_edge(1, 5, g);
+	add_edge(5, 0, g);
+	add_edge(2, 3, g);
+
+	vector< vector<Graph::vertex_descriptor> > sets(2);
+	sets[0].push_back(5);
+	sets[0].push_back(1);
+	sets[0].push_back(5);
+	sets[0].push_back(42);
+	sets[1].push_back(0);
+	sets[1].push_back(3);
+	sets[1].push_back(2);
+	vector<Graph::csr> r = induced_subgraphs(g, sets);
+
+	ASSERT_EQ(2, r[0].vertices.size());
+	ASSERT_EQ(5, r[0].vertices[0]);
+	ASSERT_EQ(1, r[0].vertices[1]);
+	ASSERT_EQ(1, r[0].targets.size());
+	ASSERT_EQ(0, r[0].offsets[1]);
+	ASSERT_EQ(0, r[0].targets[0]);
+
+	ASSERT_EQ(3, r[1].vertices.size());
+	ASSERT_EQ(1, r[1].targets.size());
+	ASSERT_EQ(0, r[1].offsets[2]);
+	ASSERT_EQ(1, r[1].offsets[3]);
+	ASSERT_EQ(1, r[1].targets[0]);}
+
+TEST(TestBatch, query_engine_1) {
+	Graph g;
+
+	for (int i = 0; i < 40; ++i)
+		add_vertex(g);
+	for (int i = 0; i < 40; ++i)
+		add_edge(i, (i * 3 + 1) % 40, g);
+
+	Graph::query_engine engine(g, 3);
+	add_edge(0, 39, g);
+
+	vector<Graph::vertex_descriptor> sources;
+	for (int i = 0; i < 40; ++i)
+		sources.push_back(i);
+	for (int k = 0; k < 4; ++k) {
+		vector<Graph::csr> r = engine.neighborhoods(sources, k);
+		ASSERT_EQ(40, r.size());
+		for (int i = 0; i < 40; ++i) {
+			ASSERT_EQ(i, r[i].vertices[0]);
+			ASSERT_GE(k + 1, (int)r[i].vertices.size());}}
+
+	// the engine answers on the graph as it was when it was built
+	vector<Graph::csr> before = engine.neighborhoods(vector<Graph::vertex_descriptor>(1, 0), 1);
+	vector<Graph::csr> after  = neighborhoods(g, vector<Graph::vertex_descriptor>(1, 0), 1);
+	ASSERT_EQ(2, before[0].vertices.size());
+	ASSERT_EQ(3, after[0].vertices.size());
+
+	vector< vector<Graph::vertex_descriptor> > sets(1, sources);
+	ASSERT_EQ(40, engine.induced_subgraphs(sets)[0].targets.size());}
+
+TEST(TestBatch, query_engine_2) {
+	Graph g;
+
+	for (int i = 0; i < 300; ++i)
+		add_vertex(g);
+	for (int i = 0; i < 300; ++i) {
+		add_edge(i, (i * 7 + 3) % 300, g);
+		add_edge(i, (i + 1) % 300, g);
+		add_edge(i, (i * i) % 300, g);}
+
+	// 150 overlapping queries share their expansions; each must match its own run
+	vector<Graph::vertex_descriptor> sources;
+	for (int i = 0; i < 150; ++i)
+		sources.push_back(i * 13 % 300);
+	Graph::query_engine engine(g, 2);
+	for (int k = 0; k < 5; ++k) {
+		vector<Graph::csr> batch = engine.neighborhoods(sources, k);
+		for (int i = 0; i < 150; ++i) {
+			vector<Graph::csr> alone = engine.neighborhoods(vector<Graph::vertex_descriptor>(1, sources[i]), k);
+			ASSERT_EQ(alone[0].vertices, batch[i].vertices);
+			ASSERT_EQ(alone[0].offsets,  batch[i].offsets);
+			ASSERT_EQ(alone[0].targets,  batch[i].targets);}}}
+
+// ----
+// walk
+// ----
+
+TEST(TestWalk, random_walks_1) {
+	Graph g;
+
+	for (int i = 0; i < 5; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	add_edge(1, 2, g);
+	add_edge(2, 0, g);
+	add_edge(3, 4, g);
+
+	vector<Graph::vertex_descriptor> starts;
+	starts.push_back(0);
+	starts.push_back(3);
+	starts.push_back(42);
+	vector<Graph::vertex_descriptor> out;
+	std::size_t steps = random_walks(g, starts, 5, out);
+
+	ASSERT_EQ(5, steps);
+	ASSERT_EQ(15, out.size());
+	const Graph::vertex_descriptor expected[] = {0, 1, 2, 0, 1, 3, 4, -1, -1, -1, 42, -1, -1, -1, -1};
+	for (int i = 0; i < 15; ++i)
+		ASSERT_EQ(expected[i], out[i]);}
+
+TEST(TestWalk, random_walks_2) {
+	Graph g;
+
+	for (int i = 0; i < 100; ++i)
+		add_vertex(g);
+	for (int i = 0; i < 100; ++i)
+		for (int j = 1; j <= 5; ++j)
+			add_edge(i, (i * j * 7 + j) % 100, g);
+
+	vector<Graph::vertex_descriptor> starts;
+	for (int i = 0; i < 1000; ++i)
+		starts.push_back(i % 100);
+	Graph::walk_options o;
+	o.p = 0.5;
+	o.q = 2;
+	o.threads = 1;
+	vector<Graph::vertex_descriptor> one;
+	vector<Graph::vertex_descriptor> four;
+	random_walks(g, starts, 20, one, o);
+	o.threads = 4;
+	random_walks(g, starts, 20, four, o);
+
+	ASSERT_EQ(one, four);
+	for (int w = 0; w < 1000; ++w) {
+		ASSERT_EQ(starts[w], one[w * 20]);
+		for (int k = 1; k < 20; ++k)
+			ASSERT_TRUE(std::binary_search(adjacent_vertices(one[w * 20 + k - 1], g).first, adjacent_vertices(one[w * 20 + k - 1], g).second, one[w * 20 + k]));}
+
+	o.seed = 2;
+	random_walks(g, starts, 20, four, o);
+	ASSERT_NE(one, four);}
+
+TEST(TestWalk, random_walks_3) {
+	Graph g;
+
+	for (int i = 0; i < 4; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	add_edge(0, 2, g);
+	add_edge(1, 0, g);
+	add_edge(1, 3, g);
+	Graph::property_map<double> w = add_edge_property(g, 1.0);
+	put(w, edge_index(0, 1, g).first, 9.0);
+
+	vector<Graph::vertex_descriptor> starts(20000, 0);
+	vector<Graph::vertex_descriptor> out;
+	Graph::walk_options o;
+	o.weights = &w;
+	for (int hub = 1; hub <= 100; hub += 99) {
+		o.hub_degree = hub;
+		random_walks(g, starts, 2, out, o);
+		ASSERT_NEAR(0.9, std::count(out.begin(), out.end(), 1) / 20000.0, 0.02);}
+
+	// node2vec with a small p returns to where it came from
+	o.weights = 0;
+	o.p = 0.01;
+	random_walks(g, starts, 3, out, o);
+	int back = 0;
+	int through = 0;
+	for (int i = 0; i < 20000; ++i)
+		if (out[i * 3 + 1] == 1) {
+			++through;
+			back += out[i * 3 + 2] == 0;}
+	ASSERT_GT(back, 0.95 * through);}
+
+TEST(TestWalk, random_walks_4) {
+	Graph g;
+
+	for (int i = 0; i < 10; ++i)
+		add_vertex(g);
+	for (int i = 0; i < 10; ++i) {
+		add_edge(i, (i + 1) % 10, g);
+		add_edge(i, (i + 3) % 10, g);}
+
+	vector<Graph::vertex_descriptor> starts;
+	for (int i = 0; i < 25; ++i)
+		starts.push_back(i % 10);
+	Graph::walk_options o;
+	o.batch = 4;
+	vector<Graph::vertex_descriptor> out;
+	random_walks(g, starts, 6, out, o);
+
+	std::FILE* f = std::fopen("TestGraph.walks", "w+b");
+	ASSERT_EQ(25 * 5, random_walks(g, starts, 6, f, o));
+	std::rewind(f);
+	vector<Graph::vertex_descriptor> read(25 * 6);
+	ASSERT_EQ(read.size(), std::fread(&read[0], sizeof(Graph::vertex_descriptor), read.size(), f));
+	std::fclose(f);
+	std::remove("TestGraph.walks");
+	ASSERT_EQ(out, read);}
+
+TEST(TestWalk, random_walks_5) {
+	Graph g;
+
+	for (int i = 0; i < 4; ++i)
+		add_vertex(g);
+	for (int i = 0; i < 4; ++i)
+		add_edge(i, (i + 1) % 4, g);
+
+	vector<Graph::vertex_descriptor> starts(8, 0);
+	Graph::walk_options o;
+	o.batch = 2;
+
+	// a stream opened for reading takes no writes
+	std::FILE* f = std::fopen("TestGraph.walks", "wb");
+	std::fclose(f);
+	f = std::fopen("TestGraph.walks", "rb");
+	ASSERT_EQ(0, random_walks(g, starts, 5, f, o));
+	ASSERT_TRUE(std::ferror(f) != 0);
+	std::fclose(f);
+	std::remove("TestGraph.walks");}
+
+TEST(TestWalk, random_walks_6) {
+	Graph g;
+
+	// on a path back and forth, every step after the first is a return
+	for (int i = 0; i < 3; ++i)
+		add_vertex(g);
+	add_edge(0, 1, g);
+	add_edge(1, 0, g);
+	add_edge(1, 2, g);
+	add_edge(2, 1, g);
+
+	vector<Graph::vertex_descriptor> starts(4, 0);
+	vector<Graph::vertex_descriptor> out;
+	Graph::walk_options o;
+	o.p = 1e-3;
+	o.q = 1e3;
+	ASSERT_EQ(4 * 9, random_walks(g, starts, 10, out, o));
+
+	o.p = 0;
+	ASSERT_DEATH(random_walks(g, starts, 10, out, o), "");}